@@ -0,0 +1,433 @@
+//
+//  RHBenchmarks.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+// Command line benchmarks for the macOS host.  Run with `rake bench`; results are printed as JSON and, with
+// -output <path>, also written to a file so runs can be compared.  -rows 1000,100000 and -stores sqlite,memory limit
+// the data path benchmarks to specific row counts and store types.
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+#import "RHManagedObject.h"
+#import "RHManagedObjectContextManager.h"
+#import "RHBulkLoader.h"
+
+#define kBenchmarkIterations 200000
+#define kBenchmarkThreads 8
+#define kBenchmarkRows @"1000,100000,1000000"
+#define kBenchmarkStores @"sqlite,memory"
+#define kBenchmarkBatchSize 10000 // Rows inserted and committed per batch, so memory usage does not grow with the row count
+#define kBenchmarkRepetitions 3 // Read benchmarks report the fastest of this many runs
+#define kBenchmarkFirstNames 100 // Each first name is shared by 1% of the rows, which the predicate benchmarks select
+#define kBenchmarkUpsertRecords 100 // Records upserted per upsert benchmark, half of them existing; the per-record loop fetches once per record
+
+@interface RHBenchmarkEmployee : RHManagedObject
+@property (nonatomic, strong) NSString *firstName;
+@property (nonatomic, strong) NSString *lastName;
+@end
+
+@implementation RHBenchmarkEmployee
+@dynamic firstName;
+@dynamic lastName;
+
++(NSString *)entityName {
+	return @"Employee";
+}
+
++(NSString *)modelName {
+	return @"RHBenchmark";
+}
+@end
+
+
+static NSManagedObjectModel *RHBenchmarkModel(void) {
+	NSEntityDescription *entity = [[NSEntityDescription alloc] init];
+	[entity setName:@"Employee"];
+	[entity setManagedObjectClassName:NSStringFromClass([RHBenchmarkEmployee class])];
+
+	NSMutableArray *properties = [NSMutableArray array];
+	for (NSString *name in [NSArray arrayWithObjects:@"firstName", @"lastName", nil]) {
+		NSAttributeDescription *attribute = [[NSAttributeDescription alloc] init];
+		[attribute setName:name];
+		[attribute setAttributeType:NSStringAttributeType];
+		[attribute setOptional:YES];
+		[properties addObject:attribute];
+	}
+	[entity setProperties:properties];
+
+	NSManagedObjectModel *model = [[NSManagedObjectModel alloc] init];
+	[model setEntities:[NSArray arrayWithObject:entity]];
+
+	return model;
+}
+
+// Configures the shared instance before it is first used; deleteStore removes it, so this is called for every store
+static RHManagedObjectContextManager *RHBenchmarkManager(NSString *storeType) {
+	RHManagedObjectContextManager *manager = [RHManagedObjectContextManager sharedInstanceWithModelName:[RHBenchmarkEmployee modelName]
+																								  bundle:[NSBundle bundleForClass:[RHBenchmarkEmployee class]]];
+	RHStoreConfiguration *configuration = [[RHStoreConfiguration alloc] init];
+	configuration.storeType = storeType;
+
+	[manager setManagedObjectModel:RHBenchmarkModel()];
+	[manager setStoreConfigurations:[NSArray arrayWithObject:configuration]];
+
+	return manager;
+}
+
+// Returns the average time of one call of block in nanoseconds
+static double RHBenchmarkMeasure(NSUInteger iterations, void (^block)(void)) {
+	NSDate *start = [NSDate date];
+
+	for (NSUInteger i = 0; i < iterations; i++) {
+		@autoreleasepool {
+			block();
+		}
+	}
+
+	return [[NSDate date] timeIntervalSinceDate:start] * 1e9 / iterations;
+}
+
+// Returns the time of one call of block in seconds
+static NSTimeInterval RHBenchmarkTime(void (^block)(void)) {
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+	@autoreleasepool {
+		block();
+	}
+
+	return CFAbsoluteTimeGetCurrent() - start;
+}
+
+// Returns the fastest of kBenchmarkRepetitions calls of block in seconds.  The main thread context is reset before each
+// call, so objects registered by an earlier run do not make later runs cheaper.
+static NSTimeInterval RHBenchmarkFastestTime(void (^block)(void)) {
+	NSTimeInterval fastest = DBL_MAX;
+
+	for (NSUInteger i = 0; i < kBenchmarkRepetitions; i++) {
+		[[RHBenchmarkEmployee managedObjectContextForCurrentThreadWithError:nil] reset];
+		fastest = MIN(fastest, RHBenchmarkTime(block));
+	}
+
+	return fastest;
+}
+
+// Runs the main run loop until the flag is set, so completion handlers dispatched to the main queue are executed
+static void RHBenchmarkWait(BOOL *done) {
+	while (!*done) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+	}
+}
+
+static NSDictionary *RHBenchmarkResult(NSTimeInterval seconds, NSUInteger rows) {
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithDouble:seconds], @"seconds",
+			[NSNumber numberWithUnsignedInteger:rows], @"rows",
+			[NSNumber numberWithDouble:(seconds > 0) ? rows / seconds : 0], @"rowsPerSecond",
+			nil];
+}
+
+static NSDictionary *RHBenchmarkDataPath(NSString *storeType, NSUInteger rowCount) {
+	Class cls = [RHBenchmarkEmployee class];
+	RHManagedObjectContextManager *manager = RHBenchmarkManager(storeType);
+	NSManagedObjectContext *moc = [cls managedObjectContextForCurrentThreadWithError:nil];
+	NSPredicate *predicate = [NSPredicate predicateWithFormat:@"firstName == %@", @"First7"];
+	NSMutableDictionary *results = [NSMutableDictionary dictionary];
+	__block NSUInteger count = 0;
+
+	// Insert and commit are timed separately, per batch of kBenchmarkBatchSize rows
+	NSTimeInterval insertTime = 0;
+	NSTimeInterval commitTime = 0;
+
+	for (NSUInteger batchStart = 0; batchStart < rowCount; batchStart += kBenchmarkBatchSize) {
+		NSUInteger batchEnd = MIN(batchStart + kBenchmarkBatchSize, rowCount);
+
+		insertTime += RHBenchmarkTime(^{
+			for (NSUInteger i = batchStart; i < batchEnd; i++) {
+				RHBenchmarkEmployee *employee = [cls newEntityWithError:nil];
+				employee.firstName = [NSString stringWithFormat:@"First%lu", (unsigned long)(i % kBenchmarkFirstNames)];
+				employee.lastName = [NSString stringWithFormat:@"Last%lu", (unsigned long)i];
+			}
+		});
+
+		commitTime += RHBenchmarkTime(^{
+			[cls commitImmediately];
+		});
+
+		[moc reset];
+	}
+
+	[results setObject:RHBenchmarkResult(insertTime, rowCount) forKey:@"insert"];
+	[results setObject:RHBenchmarkResult(commitTime, rowCount) forKey:@"commit"];
+
+	NSTimeInterval seconds = RHBenchmarkFastestTime(^{
+		count = [[cls fetchAllWithError:nil] count];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"fetch"];
+
+	seconds = RHBenchmarkFastestTime(^{
+		count = [[cls fetchWithPredicate:predicate error:nil] count];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"fetchWithPredicate"];
+
+	seconds = RHBenchmarkFastestTime(^{
+		count = [cls countWithError:nil];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"count"];
+
+	seconds = RHBenchmarkFastestTime(^{
+		count = [[cls aggregateWithType:RHAggregateCount key:@"lastName" predicate:nil defaultValue:nil error:nil] unsignedIntegerValue];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"aggregate"];
+
+	seconds = RHBenchmarkFastestTime(^{
+		count = [[cls distinctValuesWithAttribute:@"firstName" predicate:nil error:nil] count];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"distinct"];
+
+	// From the call until the completion handler has the objects on the main thread
+	RHFetchOptions *options = [cls fetchOptions];
+	options.predicate = predicate;
+
+	seconds = RHBenchmarkFastestTime(^{
+		__block BOOL done = NO;
+
+		[cls fetchInBackgroundWithOptions:options completion:^(NSArray *fetchedObjects, NSError *error) {
+			count = [fetchedObjects count];
+			done = YES;
+		}];
+
+		RHBenchmarkWait(&done);
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"backgroundFetch"];
+
+	// The main thread holds the objects a background context updates, so the merge has to refresh all of them
+	@autoreleasepool {
+		NSArray *registeredObjects = [cls fetchWithPredicate:predicate error:nil];
+		__block NSTimeInterval mergeTime = 0;
+		__block BOOL done = NO;
+
+		id observer = [[NSNotificationCenter defaultCenter] addObserverForName:RHDidMergeChangesNotification
+																		object:manager
+																		 queue:nil
+																	usingBlock:^(NSNotification *notification) {
+																		mergeTime += [[[notification userInfo] objectForKey:RHMergeDurationKey] doubleValue];
+																	}];
+
+		[manager performInBackground:^(NSManagedObjectContext *backgroundContext) {
+			for (RHBenchmarkEmployee *employee in [cls fetchWithPredicate:predicate error:nil]) {
+				employee.lastName = [employee.lastName stringByAppendingString:@"+"];
+			}
+		} completion:^(NSError *error) {
+			done = YES;
+		}];
+
+		RHBenchmarkWait(&done);
+		[[NSNotificationCenter defaultCenter] removeObserver:observer];
+
+		[results setObject:RHBenchmarkResult(mergeTime, [registeredObjects count]) forKey:@"merge"];
+	}
+
+	[moc reset];
+
+	// Upserts keyed on lastName: importRecords resolves a batch with one fetch, the loop fetches once per record
+	NSUInteger upsertCount = MIN(kBenchmarkUpsertRecords, rowCount);
+
+	seconds = RHBenchmarkTime(^{
+		NSMutableArray *records = [NSMutableArray arrayWithCapacity:upsertCount];
+		for (NSUInteger i = 0; i < upsertCount; i++) {
+			NSString *lastName = (i % 2) ? [NSString stringWithFormat:@"Last%lu", (unsigned long)(i * (rowCount / upsertCount))] : [NSString stringWithFormat:@"Import%lu", (unsigned long)i];
+			[records addObject:[NSDictionary dictionaryWithObjectsAndKeys:@"Import", @"firstName", lastName, @"lastName", nil]];
+		}
+
+		count = [cls importRecords:records uniqueKey:@"lastName" error:nil];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"upsertImportRecords"];
+
+	seconds = RHBenchmarkTime(^{
+		for (NSUInteger i = 0; i < upsertCount; i++) {
+			NSString *lastName = (i % 2) ? [NSString stringWithFormat:@"Last%lu", (unsigned long)(i * (rowCount / upsertCount) + 1)] : [NSString stringWithFormat:@"Loop%lu", (unsigned long)i];
+			RHBenchmarkEmployee *employee = [cls newOrExistingEntityWithPredicate:[NSPredicate predicateWithFormat:@"lastName == %@", lastName] error:nil];
+			employee.firstName = @"Loop";
+			employee.lastName = lastName;
+		}
+
+		[cls commitImmediately];
+	});
+	[results setObject:RHBenchmarkResult(seconds, upsertCount) forKey:@"upsertNewOrExisting"];
+
+	[moc reset];
+
+	seconds = RHBenchmarkTime(^{
+		count = [cls deleteWithPredicate:predicate error:nil];
+		[cls commitImmediately];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"deleteWithPredicate"];
+
+	// New rows imported in batches of kBenchmarkBatchSize records; only importRecords is timed, not building the records
+	NSTimeInterval importTime = 0;
+	NSUInteger importCount = 0;
+
+	for (NSUInteger batchStart = 0; batchStart < rowCount; batchStart += kBenchmarkBatchSize) {
+		@autoreleasepool {
+			NSUInteger batchEnd = MIN(batchStart + kBenchmarkBatchSize, rowCount);
+			NSMutableArray *records = [NSMutableArray arrayWithCapacity:batchEnd - batchStart];
+
+			for (NSUInteger i = batchStart; i < batchEnd; i++) {
+				[records addObject:[NSDictionary dictionaryWithObjectsAndKeys:
+									[NSString stringWithFormat:@"First%lu", (unsigned long)(i % kBenchmarkFirstNames)], @"firstName",
+									[NSString stringWithFormat:@"Imported%lu", (unsigned long)i], @"lastName", nil]];
+			}
+
+			importTime += RHBenchmarkTime(^{
+				count = [cls importRecords:records uniqueKey:@"lastName" error:nil];
+			});
+			importCount += count;
+		}
+	}
+	[results setObject:RHBenchmarkResult(importTime, importCount) forKey:@"importRecords"];
+
+	// The NDJSON file is written before the timed load
+	NSString *bulkPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"RHBenchmark.ndjson"];
+	[[NSFileManager defaultManager] createFileAtPath:bulkPath contents:nil attributes:nil];
+	NSFileHandle *bulkFile = [NSFileHandle fileHandleForWritingAtPath:bulkPath];
+
+	for (NSUInteger i = 0; i < rowCount; i++) {
+		@autoreleasepool {
+			NSString *line = [NSString stringWithFormat:@"{\"firstName\":\"First%lu\",\"lastName\":\"Bulk%lu\"}\n", (unsigned long)(i % kBenchmarkFirstNames), (unsigned long)i];
+			[bulkFile writeData:[line dataUsingEncoding:NSUTF8StringEncoding]];
+		}
+	}
+	[bulkFile closeFile];
+
+	seconds = RHBenchmarkTime(^{
+		RHBulkLoader *loader = [[RHBulkLoader alloc] initWithEntityClass:cls];
+		count = [loader loadFileAtURL:[NSURL fileURLWithPath:bulkPath] format:RHBulkLoaderFormatNDJSON error:nil];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"bulkLoad"];
+
+	[[NSFileManager defaultManager] removeItemAtPath:bulkPath error:nil];
+	[moc reset];
+
+	// Deletes the bulk loaded rows; stores without batch requests fall back to deleting managed objects
+	seconds = RHBenchmarkTime(^{
+		count = [cls batchDeleteWithPredicate:[NSPredicate predicateWithFormat:@"lastName BEGINSWITH %@", @"Bulk"] error:nil];
+		[cls commitImmediately];
+	});
+	[results setObject:RHBenchmarkResult(seconds, count) forKey:@"batchDelete"];
+
+	[manager deleteStore];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[storeType isEqualToString:NSInMemoryStoreType] ? @"memory" : @"sqlite", @"store",
+			[NSNumber numberWithUnsignedInteger:rowCount], @"rows",
+			results, @"results",
+			nil];
+}
+
+static NSDictionary *RHBenchmarkMetadata(void) {
+	Class cls = [RHBenchmarkEmployee class];
+	__block NSError *error = nil;
+
+	// Warm up both paths so the store and the cache exist before measuring
+	[cls entityDescriptionWithError:&error];
+
+	// The per-call chain before the metadata cache: model name, bundle, shared instance lookup, thread context and entity lookup by name
+	double uncached = RHBenchmarkMeasure(kBenchmarkIterations, ^{
+		RHManagedObjectContextManager *manager = [RHManagedObjectContextManager sharedInstanceWithModelName:[cls modelName] bundle:[NSBundle bundleForClass:cls]];
+		NSManagedObjectContext *moc = [manager managedObjectContextForCurrentThreadWithError:&error];
+		[NSEntityDescription entityForName:[cls entityName] inManagedObjectContext:moc];
+	});
+
+	double cached = RHBenchmarkMeasure(kBenchmarkIterations, ^{
+		[cls managedObjectContextManager];
+		[cls entityDescriptionWithError:&error];
+	});
+
+	// The same cached lookups from several threads at once, to show reads do not contend on a lock
+	NSDate *start = [NSDate date];
+	dispatch_apply(kBenchmarkThreads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+		for (NSUInteger i = 0; i < kBenchmarkIterations; i++) {
+			@autoreleasepool {
+				[cls managedObjectContextManager];
+				[cls entityDescriptionWithError:nil];
+			}
+		}
+	});
+	double concurrent = [[NSDate date] timeIntervalSinceDate:start] * 1e9 / kBenchmarkIterations;
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:kBenchmarkIterations], @"iterations",
+			[NSNumber numberWithDouble:uncached], @"uncachedNanosecondsPerCall",
+			[NSNumber numberWithDouble:cached], @"cachedNanosecondsPerCall",
+			[NSNumber numberWithDouble:uncached / cached], @"speedup",
+			[NSNumber numberWithUnsignedInteger:kBenchmarkThreads], @"threads",
+			[NSNumber numberWithDouble:concurrent], @"cachedConcurrentNanosecondsPerCall",
+			nil];
+}
+
+int main(int argc, const char * argv[]) {
+	@autoreleasepool {
+		// -rows, -stores and -output are read from the arguments by NSUserDefaults
+		NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+		NSString *rows = [defaults stringForKey:@"rows"] ? [defaults stringForKey:@"rows"] : kBenchmarkRows;
+		NSString *stores = [defaults stringForKey:@"stores"] ? [defaults stringForKey:@"stores"] : kBenchmarkStores;
+		NSString *outputPath = [defaults stringForKey:@"output"];
+
+		NSProcessInfo *processInfo = [NSProcessInfo processInfo];
+		NSMutableDictionary *results = [NSMutableDictionary dictionary];
+
+		[results setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+							[processInfo operatingSystemVersionString], @"operatingSystem",
+							[NSNumber numberWithUnsignedInteger:[processInfo activeProcessorCount]], @"processors",
+							[NSNumber numberWithDouble:[[NSDate date] timeIntervalSince1970]], @"timestamp",
+							nil]
+					forKey:@"environment"];
+
+		RHManagedObjectContextManager *manager = RHBenchmarkManager(NSSQLiteStoreType);
+		[results setObject:RHBenchmarkMetadata() forKey:@"metadata"];
+		[manager deleteStore];
+
+		NSMutableArray *dataPath = [NSMutableArray array];
+
+		for (NSString *store in [stores componentsSeparatedByString:@","]) {
+			NSString *storeType = [store isEqualToString:@"memory"] ? NSInMemoryStoreType : NSSQLiteStoreType;
+
+			for (NSString *rowCount in [rows componentsSeparatedByString:@","]) {
+				@autoreleasepool {
+					[dataPath addObject:RHBenchmarkDataPath(storeType, (NSUInteger)[rowCount longLongValue])];
+				}
+			}
+		}
+
+		[results setObject:dataPath forKey:@"dataPath"];
+
+		NSData *json = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:nil];
+		printf("%s\n", [[[NSString alloc] initWithData:json encoding:NSUTF8StringEncoding] UTF8String]);
+
+		if (outputPath && ![json writeToFile:outputPath atomically:YES]) {
+			fprintf(stderr, "Could not write %s\n", [outputPath UTF8String]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+//
+//  RHBulkLoader.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+typedef enum {
+	RHBulkLoaderFormatNDJSON,
+	RHBulkLoaderFormatCSV
+} RHBulkLoaderFormat;
+
+typedef void (^RHBulkLoaderProgressBlock)(NSUInteger rowsLoaded, unsigned long long bytesRead, unsigned long long totalBytes, double rowsPerSecond);
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHBulkLoader interface -
+/**
+ RHBulkLoader streams records from an NDJSON or CSV file into the persistent store of an RHManagedObject subclass. Records are read one at a time and written in batches with NSBatchInsertRequest, so managed objects are never created and memory usage is bounded by the batch size regardless of the file size. This makes it suitable for seeding the store on first launch independently of the model version. If batch inserts are not available (iOS 12 and earlier, or stores other than SQLite), the records are inserted as managed objects in a temporary managed object context that is committed and discarded per batch, so the current thread's managed object context and its pending changes are left untouched.
+
+ Loading should be done in a background thread.
+
+ */
+@interface RHBulkLoader : NSObject
+
+/**
+ *  Initialize an RHBulkLoader instance for a specific entity.
+ *
+ *  @param entityClass An RHManagedObject subclass.
+ *
+ *  @return An initialized RHBulkLoader object.
+ */
+-(id)initWithEntityClass:(Class)entityClass;
+
+/**
+ *  The RHManagedObject subclass the records are loaded into.
+ */
+@property (nonatomic, readonly) Class entityClass;
+
+/**
+ *  The number of records written per batch. Defaults to 1000.
+ */
+@property (nonatomic, assign) NSUInteger batchSize;
+
+/**
+ *  Maps column names (CSV) or keys (NDJSON) to attribute names. Columns that are not in this dictionary are mapped to the attribute with the same name. A column without a matching attribute causes an RHManagedObjectErrorInvalidRecord error.
+ */
+@property (nonatomic, strong) NSDictionary *columnMapping;
+
+/**
+ *  Whether or not the inserted objects are merged into the main thread managed object context and the managed object contexts of the other threads after each batch. Only required if an NSFetchedResultsController must observe the inserted objects. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL mergesInsertedObjects;
+
+/**
+ *  This block is executed after each batch on the loading thread with the number of rows loaded, the number of bytes read, the size of the file and the average throughput in rows per second.
+ */
+@property (nonatomic, copy) RHBulkLoaderProgressBlock progressBlock;
+
+/**
+ *  Loads all records from a file. CSV files must have a header row with the column names. Strings are converted to the type of the attribute: numbers, booleans (true/false, yes/no, 1/0), dates (ISO 8601 or seconds since 1970) and binary data (base64). Empty values are stored as nil. A CSV row with more fields than the header, a record without values, or a record with a number or date that can't be converted, causes an RHManagedObjectErrorInvalidRecord error whose userInfo contains the line number under the RHLineNumber key.
+ *
+ *  @param fileURL The URL of the file.
+ *  @param format  The format of the file.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of loaded records. If an error occurred this will return NSNotFound; batches written before the error remain in the persistent store.
+ */
+-(NSUInteger)loadFileAtURL:(NSURL *)fileURL
+                    format:(RHBulkLoaderFormat)format
+                     error:(NSError **)error;
+
+@end
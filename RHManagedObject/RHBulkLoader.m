@@ -0,0 +1,487 @@
+//
+//  RHBulkLoader.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHBulkLoader.h"
+#import "RHManagedObject.h"
+#import "RHManagedObjectContextManager.h"
+
+#define kBulkLoaderBatchSize 1000
+#define kBulkLoaderReadLength 65536
+
+@interface RHBulkLoader()
+@property (nonatomic, readwrite) Class entityClass;
+@property (nonatomic, strong) NSDictionary *attributes;
+@property (nonatomic, strong) NSArray *columnAttributes;
+@property (nonatomic, strong) NSArray *dateFormatters;
+
+-(NSDictionary *)recordWithLineData:(NSData *)lineData format:(RHBulkLoaderFormat)format error:(NSError **)error;
+-(NSArray *)fieldsWithCSVLine:(NSString *)line;
+-(id)valueForAttribute:(NSAttributeDescription *)attribute fromValue:(id)value error:(NSError **)error;
+-(NSError *)invalidRecordErrorWithDescription:(NSString *)description;
+-(BOOL)writeBatch:(NSArray *)batch error:(NSError **)error;
+@end
+
+@implementation RHBulkLoader
+
+-(id)initWithEntityClass:(Class)entityClass {
+	if (self=[super init]) {
+		self.entityClass = entityClass;
+		self.batchSize = kBulkLoaderBatchSize;
+
+		NSMutableArray *dateFormatters = [NSMutableArray array];
+		for (NSString *dateFormat in [NSArray arrayWithObjects:@"yyyy-MM-dd'T'HH:mm:ss.SSSZZZZZ", @"yyyy-MM-dd'T'HH:mm:ssZZZZZ", @"yyyy-MM-dd", nil]) {
+			NSDateFormatter *dateFormatter = [NSDateFormatter new];
+			[dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+			[dateFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+			[dateFormatter setDateFormat:dateFormat];
+			[dateFormatters addObject:dateFormatter];
+		}
+		self.dateFormatters = dateFormatters;
+	}
+	return self;
+}
+
+-(NSUInteger)loadFileAtURL:(NSURL *)fileURL
+                    format:(RHBulkLoaderFormat)format
+                     error:(NSError **)error {
+
+	NSEntityDescription *entity = [self.entityClass entityDescriptionWithError:error];
+
+	if (entity == nil) {
+		return NSNotFound;
+	}
+
+	NSInputStream *stream = [NSInputStream inputStreamWithURL:fileURL];
+	[stream open];
+
+	if ((stream == nil) || ([stream streamStatus] == NSStreamStatusError)) {
+		if (error) {
+			*error = [stream streamError] ? [stream streamError] : [NSError errorWithDomain:RHManagedObjectErrorDomain
+																					  code:RHManagedObjectErrorFileNotReadable
+																				  userInfo:[NSDictionary dictionaryWithObject:fileURL forKey:NSURLErrorKey]];
+		}
+		return NSNotFound;
+	}
+
+	self.attributes = [entity attributesByName];
+	self.columnAttributes = nil;
+
+	unsigned long long totalBytes = [[[NSFileManager defaultManager] attributesOfItemAtPath:[fileURL path] error:nil] fileSize];
+	unsigned long long bytesRead = 0;
+	NSUInteger loaded = 0;
+	NSUInteger lineNumber = 0;
+	NSDate *start = [NSDate date];
+
+	NSMutableData *buffer = [NSMutableData data];
+	NSMutableArray *batch = [NSMutableArray arrayWithCapacity:self.batchSize];
+	uint8_t bytes[kBulkLoaderReadLength];
+	BOOL endOfStream = NO;
+	NSError *loadError = nil;
+
+	while (!endOfStream && (loadError == nil)) {
+		@autoreleasepool {
+			NSInteger length = [stream read:bytes maxLength:kBulkLoaderReadLength];
+
+			if (length < 0) {
+				loadError = [stream streamError];
+				continue;
+			} else if (length == 0) {
+				endOfStream = YES;
+			} else {
+				[buffer appendBytes:bytes length:length];
+				bytesRead += length;
+			}
+
+			const char *data = [buffer bytes];
+			NSUInteger available = [buffer length];
+			NSUInteger lineStart = 0;
+			BOOL inQuotes = NO;
+
+			for (NSUInteger i = 0; (i < available) && (loadError == nil); i++) {
+				// A quoted CSV field may contain line breaks
+				if ((format == RHBulkLoaderFormatCSV) && (data[i] == '"')) {
+					inQuotes = !inQuotes;
+				}
+
+				BOOL isLineBreak = (data[i] == '\n') && !inQuotes;
+				BOOL isLastByte = endOfStream && (i == available - 1);
+
+				if (!isLineBreak && !isLastByte) {
+					continue;
+				}
+
+				NSUInteger lineEnd = isLineBreak ? i : i + 1;
+				if ((lineEnd > lineStart) && (data[lineEnd - 1] == '\r')) {
+					lineEnd--;
+				}
+
+				NSData *lineData = [NSData dataWithBytesNoCopy:(void *)(data + lineStart) length:lineEnd - lineStart freeWhenDone:NO];
+				lineStart = i + 1;
+				lineNumber++;
+
+				if ([lineData length] == 0) {
+					continue;
+				}
+
+				NSDictionary *record = [self recordWithLineData:lineData format:format error:&loadError];
+
+				if (loadError) {
+					NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithDictionary:[loadError userInfo]];
+					[userInfo setObject:[NSNumber numberWithUnsignedInteger:lineNumber] forKey:@"RHLineNumber"];
+					loadError = [NSError errorWithDomain:[loadError domain] code:[loadError code] userInfo:userInfo];
+				} else if (record) {
+					[batch addObject:record];
+				}
+
+				if (([batch count] >= self.batchSize) && (loadError == nil)) {
+					if ([self writeBatch:batch error:&loadError]) {
+						loaded += [batch count];
+						[batch removeAllObjects];
+
+						if (self.progressBlock) {
+							self.progressBlock(loaded, bytesRead, totalBytes, loaded / MAX(-[start timeIntervalSinceNow], 0.001));
+						}
+					}
+				}
+			}
+
+			[buffer replaceBytesInRange:NSMakeRange(0, MIN(lineStart, available)) withBytes:NULL length:0];
+		}
+	}
+
+	[stream close];
+
+	if ((loadError == nil) && ([batch count] > 0)) {
+		if ([self writeBatch:batch error:&loadError]) {
+			loaded += [batch count];
+
+			if (self.progressBlock) {
+				self.progressBlock(loaded, bytesRead, totalBytes, loaded / MAX(-[start timeIntervalSinceNow], 0.001));
+			}
+		}
+	}
+
+	if (loadError) {
+		if (error) {
+			*error = loadError;
+		}
+		return NSNotFound;
+	}
+
+	return loaded;
+}
+
+-(NSDictionary *)recordWithLineData:(NSData *)lineData format:(RHBulkLoaderFormat)format error:(NSError **)error {
+	NSMutableDictionary *record = [NSMutableDictionary dictionary];
+
+	if (format == RHBulkLoaderFormatNDJSON) {
+		id values = [NSJSONSerialization JSONObjectWithData:lineData options:0 error:error];
+
+		if (![values isKindOfClass:[NSDictionary class]]) {
+			if (error && (values != nil)) {
+				*error = [self invalidRecordErrorWithDescription:@"The record is not a JSON object."];
+			}
+			return nil;
+		}
+
+		for (NSString *column in values) {
+			NSString *name = [self.columnMapping objectForKey:column] ? [self.columnMapping objectForKey:column] : column;
+			NSAttributeDescription *attribute = [self.attributes objectForKey:name];
+
+			if (attribute == nil) {
+				if (error) {
+					*error = [self invalidRecordErrorWithDescription:[NSString stringWithFormat:@"The key %@ does not match an attribute.", column]];
+				}
+				return nil;
+			}
+
+			NSError *valueError = nil;
+			id value = [self valueForAttribute:attribute fromValue:[values objectForKey:column] error:&valueError];
+
+			if (valueError) {
+				if (error) {
+					*error = valueError;
+				}
+				return nil;
+			}
+
+			if (value) {
+				[record setObject:value forKey:name];
+			}
+		}
+	} else {
+		NSString *line = [[NSString alloc] initWithData:lineData encoding:NSUTF8StringEncoding];
+
+		if (line == nil) {
+			if (error) {
+				*error = [self invalidRecordErrorWithDescription:@"The line is not valid UTF-8."];
+			}
+			return nil;
+		}
+
+		NSArray *fields = [self fieldsWithCSVLine:line];
+
+		// The first row contains the column names, resolve them to attributes once
+		if (self.columnAttributes == nil) {
+			NSMutableArray *columnAttributes = [NSMutableArray arrayWithCapacity:[fields count]];
+
+			for (NSString *column in fields) {
+				NSString *name = [self.columnMapping objectForKey:column] ? [self.columnMapping objectForKey:column] : column;
+				NSAttributeDescription *attribute = [self.attributes objectForKey:name];
+
+				if (attribute == nil) {
+					if (error) {
+						*error = [self invalidRecordErrorWithDescription:[NSString stringWithFormat:@"The column %@ does not match an attribute.", column]];
+					}
+					return nil;
+				}
+
+				[columnAttributes addObject:attribute];
+			}
+
+			self.columnAttributes = columnAttributes;
+			return nil;
+		}
+
+		// Missing trailing fields are empty, but a field without a column would be dropped
+		if ([fields count] > [self.columnAttributes count]) {
+			if (error) {
+				*error = [self invalidRecordErrorWithDescription:[NSString stringWithFormat:@"The record has %lu fields, but the header only %lu columns.", (unsigned long)[fields count], (unsigned long)[self.columnAttributes count]]];
+			}
+			return nil;
+		}
+
+		for (NSUInteger i = 0; i < [fields count]; i++) {
+			NSAttributeDescription *attribute = [self.columnAttributes objectAtIndex:i];
+			NSError *valueError = nil;
+			id value = [self valueForAttribute:attribute fromValue:[fields objectAtIndex:i] error:&valueError];
+
+			if (valueError) {
+				if (error) {
+					*error = valueError;
+				}
+				return nil;
+			}
+
+			if (value) {
+				[record setObject:value forKey:[attribute name]];
+			}
+		}
+	}
+
+	// A record without values would be inserted as an empty object
+	if ([record count] == 0) {
+		if (error) {
+			*error = [self invalidRecordErrorWithDescription:@"The record has no values."];
+		}
+		return nil;
+	}
+
+	return record;
+}
+
+// RFC 4180: fields are separated by commas, may be enclosed in double quotes, and quotes are escaped by doubling them.
+-(NSArray *)fieldsWithCSVLine:(NSString *)line {
+	NSUInteger length = [line length];
+	unichar *characters = malloc(sizeof(unichar) * (length + 1));
+	unichar *field = malloc(sizeof(unichar) * (length + 1));
+	[line getCharacters:characters range:NSMakeRange(0, length)];
+
+	NSMutableArray *fields = [NSMutableArray array];
+	NSUInteger fieldLength = 0;
+	BOOL inQuotes = NO;
+
+	for (NSUInteger i = 0; i < length; i++) {
+		unichar c = characters[i];
+
+		if (inQuotes) {
+			if ((c == '"') && (i + 1 < length) && (characters[i + 1] == '"')) {
+				field[fieldLength++] = c;
+				i++;
+			} else if (c == '"') {
+				inQuotes = NO;
+			} else {
+				field[fieldLength++] = c;
+			}
+		} else if (c == '"') {
+			inQuotes = YES;
+		} else if (c == ',') {
+			[fields addObject:[NSString stringWithCharacters:field length:fieldLength]];
+			fieldLength = 0;
+		} else {
+			field[fieldLength++] = c;
+		}
+	}
+
+	[fields addObject:[NSString stringWithCharacters:field length:fieldLength]];
+
+	free(characters);
+	free(field);
+
+	return fields;
+}
+
+-(NSError *)invalidRecordErrorWithDescription:(NSString *)description {
+	return [NSError errorWithDomain:RHManagedObjectErrorDomain
+	                           code:RHManagedObjectErrorInvalidRecord
+	                       userInfo:[NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey]];
+}
+
+// Returns nil without an error for empty values, which are stored as nil
+-(id)valueForAttribute:(NSAttributeDescription *)attribute fromValue:(id)value error:(NSError **)error {
+	if ((attribute == nil) || (value == nil) || [value isKindOfClass:[NSNull class]]) {
+		return nil;
+	}
+
+	BOOL isString = [value isKindOfClass:[NSString class]];
+
+	if (isString && ([value length] == 0) && ([attribute attributeType] != NSStringAttributeType)) {
+		return nil;
+	}
+
+	switch ([attribute attributeType]) {
+		case NSInteger16AttributeType:
+		case NSInteger32AttributeType:
+		case NSInteger64AttributeType:
+			if (isString) {
+				NSScanner *scanner = [NSScanner scannerWithString:value];
+				long long integerValue;
+				if ([scanner scanLongLong:&integerValue] && [scanner isAtEnd]) {
+					return [NSNumber numberWithLongLong:integerValue];
+				}
+				break;
+			}
+			return value;
+
+		case NSDecimalAttributeType:
+			if (isString) {
+				NSScanner *scanner = [NSScanner scannerWithString:value];
+				NSDecimal decimalValue;
+				[scanner setLocale:[NSDictionary dictionaryWithObject:@"." forKey:NSLocaleDecimalSeparator]];
+				if ([scanner scanDecimal:&decimalValue] && [scanner isAtEnd]) {
+					return [NSDecimalNumber decimalNumberWithDecimal:decimalValue];
+				}
+				break;
+			}
+			return [NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]];
+
+		case NSDoubleAttributeType:
+		case NSFloatAttributeType:
+			if (isString) {
+				NSScanner *scanner = [NSScanner scannerWithString:value];
+				double doubleValue;
+				if ([scanner scanDouble:&doubleValue] && [scanner isAtEnd]) {
+					return [NSNumber numberWithDouble:doubleValue];
+				}
+				break;
+			}
+			return value;
+
+		case NSBooleanAttributeType:
+			return isString ? [NSNumber numberWithBool:[value boolValue]] : value;
+
+		case NSStringAttributeType:
+			return isString ? value : [value description];
+
+		case NSDateAttributeType:
+			if ([value isKindOfClass:[NSNumber class]]) {
+				return [NSDate dateWithTimeIntervalSince1970:[value doubleValue]];
+			} else if (isString) {
+				for (NSDateFormatter *dateFormatter in self.dateFormatters) {
+					NSDate *date = [dateFormatter dateFromString:value];
+					if (date) {
+						return date;
+					}
+				}
+
+				NSScanner *scanner = [NSScanner scannerWithString:value];
+				double seconds;
+				if ([scanner scanDouble:&seconds] && [scanner isAtEnd]) {
+					return [NSDate dateWithTimeIntervalSince1970:seconds];
+				}
+				break;
+			}
+			return nil;
+
+		case NSBinaryDataAttributeType:
+			return isString ? [[NSData alloc] initWithBase64EncodedString:value options:NSDataBase64DecodingIgnoreUnknownCharacters] : nil;
+
+		default:
+			return value;
+	}
+
+	if (error) {
+		*error = [self invalidRecordErrorWithDescription:[NSString stringWithFormat:@"The value %@ can't be converted for the attribute %@.", value, [attribute name]]];
+	}
+	return nil;
+}
+
+-(BOOL)writeBatch:(NSArray *)batch error:(NSError **)error {
+	RHManagedObjectContextManager *manager = [self.entityClass managedObjectContextManager];
+
+	// NSBatchInsertRequest is only available on iOS 13 and later, and only for SQLite stores
+	if (@available(iOS 13.0, macOS 10.15, *)) {
+		NSError *storeError = nil;
+
+		if ([manager supportsBatchRequestsForEntity:[self.entityClass entityDescriptionWithError:nil] error:&storeError]) {
+			NSEntityDescription *entity = [self.entityClass entityDescriptionWithError:error];
+			NSBatchInsertRequest *request = [[NSBatchInsertRequest alloc] initWithEntity:entity objects:batch];
+			[request setResultType:self.mergesInsertedObjects ? NSBatchInsertRequestResultTypeObjectIDs : NSBatchInsertRequestResultTypeCount];
+
+			return [manager executeBatchRequest:request error:error] != nil;
+		}
+
+		// The stores could not be loaded, which is not a reason to fall back
+		if (storeError) {
+			if (error) {
+				*error = storeError;
+			}
+			return NO;
+		}
+	}
+
+	// A temporary context keeps the current thread's objects and pending changes out of the commit, and is discarded afterwards
+	__block NSError *batchError = nil;
+
+	BOOL performed = [manager performWithTemporaryContext:^(NSManagedObjectContext *temporaryContext) {
+		for (NSDictionary *record in batch) {
+			NSManagedObject *object = [self.entityClass newEntityWithError:&batchError];
+			[object setValuesForKeysWithDictionary:record];
+		}
+
+		if (batchError == nil) {
+			batchError = [self.entityClass commitImmediately];
+		}
+	} error:&batchError];
+
+	if (!performed || batchError) {
+		if (error) {
+			*error = batchError;
+		}
+		return NO;
+	}
+
+	return YES;
+}
+
+@end
@@ -25,6 +25,7 @@
 //  Motivated by https://github.com/AshFurrow/UICollectionView-NSFetchedResultsController
 
 #import "RHCoreDataCollectionViewController.h"
+#import "RHManagedObjectContextManager.h"
 
 @interface RHCoreDataCollectionViewController ()
 @property (nonatomic, strong) NSMutableArray *objectChanges;
@@ -43,6 +44,14 @@
     self.sectionChanges = [NSMutableArray array];
 }
 
+-(void)setFetchedResultsController:(NSFetchedResultsController *)controller {
+	fetchedResultsController = controller;
+
+	if (controller) {
+		[RHManagedObjectContextManager registerFetchedResultsController:controller];
+	}
+}
+
 -(NSFetchedResultsController *)fetchedResultsController {
 	NSLog(@"Implement in subclass");
 	abort();
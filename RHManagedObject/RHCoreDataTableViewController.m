@@ -143,6 +143,14 @@ static UITableViewRowAnimation deleteRowAnimation = UITableViewRowAnimationAutom
     }
 }
 
+-(void)setFetchedResultsController:(NSFetchedResultsController *)controller {
+	fetchedResultsController = controller;
+
+	if (controller) {
+		[RHManagedObjectContextManager registerFetchedResultsController:controller];
+	}
+}
+
 #pragma mark Abstact classes (implment in sub-class)
 
 -(NSPredicate *)predicate {
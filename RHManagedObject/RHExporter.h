@@ -0,0 +1,121 @@
+//
+//  RHExporter.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+typedef enum {
+	RHExporterFormatJSON,
+	RHExporterFormatNDJSON,
+	RHExporterFormatBinaryPropertyList
+} RHExporterFormat;
+
+typedef void (^RHExporterProgressBlock)(NSUInteger rowsExported, unsigned long long bytesWritten, double rowsPerSecond);
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHExporter interface -
+/**
+ RHExporter streams the objects of an RHManagedObject subclass that match a predicate into a file or an output stream, as a JSON array, NDJSON (one JSON object per line) or a binary property list with an array at the top. The attributes are read with dictionary fetches in batches and written as each batch completes, so managed objects are not created for them and memory usage is bounded by the batch size (plus, for binary property lists, a reference per record for the top level array and 8 bytes per written value for the offset table). The object IDs are fetched one page per batch, so objects inserted or deleted by other threads during the export may shift the pages. Exported JSON files can be loaded again with RHBulkLoader.
+
+ Values are converted for the format while the records are built: dates become ISO 8601 strings and binary data becomes base64 in JSON, and both stay native in property lists. Values that can not be represented (e.g., transformable attributes) are left out, as are nil values. The export reflects the persistent store, so unsaved changes are not included.
+
+ Exporting should be done in a background thread.
+
+ */
+@interface RHExporter : NSObject
+
+/**
+ *  Initialize an RHExporter instance for a specific entity.
+ *
+ *  @param entityClass An RHManagedObject subclass.
+ *
+ *  @return An initialized RHExporter object.
+ */
+-(id)initWithEntityClass:(Class)entityClass;
+
+/**
+ *  The RHManagedObject subclass the objects are exported from.
+ */
+@property (nonatomic, readonly) Class entityClass;
+
+/**
+ *  The predicate that should match with the exported objects. If nil all objects are exported.
+ */
+@property (nonatomic, strong) NSPredicate *predicate;
+
+/**
+ *  The order of the exported objects. If nil the order is undefined.
+ */
+@property (nonatomic, strong) NSArray *sortDescriptors;
+
+/**
+ *  The number of objects read and written per batch. Defaults to 1000.
+ */
+@property (nonatomic, assign) NSUInteger batchSize;
+
+/**
+ *  The number of relationship levels that are written as nested objects. Defaults to 0, which writes only the attributes (and the relationships as IDs if exportsRelationshipIDs is YES).
+ */
+@property (nonatomic, assign) NSUInteger relationshipDepth;
+
+/**
+ *  Whether or not relationships that are not nested are written as the URI representations of the object IDs, a string for to-one relationships and an array for to-many relationships. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL exportsRelationshipIDs;
+
+/**
+ *  If set, each written object (nested ones included) contains the URI representation of its object ID with this key, so relationship IDs can be resolved. Defaults to nil.
+ */
+@property (nonatomic, copy) NSString *objectIDKey;
+
+/**
+ *  This block is executed after each batch on the exporting thread with the number of objects exported, the number of bytes written and the average throughput in objects per second.
+ */
+@property (nonatomic, copy) RHExporterProgressBlock progressBlock;
+
+/**
+ *  Exports the objects to a file, replacing it if it exists.
+ *
+ *  @param fileURL The URL of the file.
+ *  @param format  The format of the file.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of exported objects. If an error occurred this will return NSNotFound.
+ */
+-(NSUInteger)exportToFileAtURL:(NSURL *)fileURL
+                        format:(RHExporterFormat)format
+                         error:(NSError **)error;
+
+/**
+ *  Exports the objects to an output stream.
+ *
+ *  @param stream An open output stream. The stream is not closed.
+ *  @param format The format of the output.
+ *  @param error  If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of exported objects. If an error occurred this will return NSNotFound; the stream then contains an incomplete document.
+ */
+-(NSUInteger)exportToStream:(NSOutputStream *)stream
+                     format:(RHExporterFormat)format
+                      error:(NSError **)error;
+
+@end
@@ -0,0 +1,696 @@
+//
+//  RHExporter.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHExporter.h"
+#import "RHManagedObject.h"
+#import "RHManagedObjectContextManager.h"
+
+#define kExporterBatchSize 1000
+#define kExporterFlushLength 65536
+#define kExporterObjectIDKey @"objectID"
+#define kBinaryPropertyListObjectRefSize 4 // Fixed, since containers are written before the number of objects is known
+
+static void RHAppendBigEndian(NSMutableData *data, uint64_t value, NSUInteger size) {
+	uint8_t bytes[8];
+
+	for (NSUInteger i = 0; i < size; i++) {
+		bytes[i] = (uint8_t)(value >> (8 * (size - 1 - i)));
+	}
+
+	[data appendBytes:bytes length:size];
+}
+
+
+// Writes a binary property list (bplist00) front to back: every value is written before the containers that refer to it,
+// and the offset table and trailer follow at the end. Only dictionary keys are uniqued, since they repeat for every record.
+@interface RHBinaryPropertyListWriter : NSObject
+@property (nonatomic, strong) NSMutableData *buffer;
+@property (nonatomic, assign) unsigned long long flushedLength;
+@property (nonatomic, strong) NSMutableData *offsets;
+@property (nonatomic, strong) NSMutableDictionary *keyRefs;
+-(void)appendHeader;
+-(uint32_t)appendObject:(id)object;
+-(uint32_t)appendArrayWithRefs:(NSData *)refs count:(NSUInteger)count;
+-(BOOL)appendTrailerWithTopObject:(uint32_t)topObject flush:(BOOL (^)(NSError **error))flush error:(NSError **)error;
+@end
+
+@implementation RHBinaryPropertyListWriter
+
+-(id)init {
+	if (self=[super init]) {
+		self.buffer = [NSMutableData data];
+		self.offsets = [NSMutableData data];
+		self.keyRefs = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+-(void)appendHeader {
+	[self.buffer appendBytes:"bplist00" length:8];
+}
+
+-(uint32_t)beginObject {
+	uint64_t offset = self.flushedLength + [self.buffer length];
+	[self.offsets appendBytes:&offset length:sizeof(offset)];
+
+	return (uint32_t)([self.offsets length] / sizeof(offset) - 1);
+}
+
+-(void)appendInteger:(int64_t)value {
+	if (value < 0 || value > UINT32_MAX) {
+		[self.buffer appendBytes:"\x13" length:1];
+		RHAppendBigEndian(self.buffer, (uint64_t)value, 8);
+	} else if (value > UINT16_MAX) {
+		[self.buffer appendBytes:"\x12" length:1];
+		RHAppendBigEndian(self.buffer, (uint64_t)value, 4);
+	} else if (value > UINT8_MAX) {
+		[self.buffer appendBytes:"\x11" length:1];
+		RHAppendBigEndian(self.buffer, (uint64_t)value, 2);
+	} else {
+		[self.buffer appendBytes:"\x10" length:1];
+		RHAppendBigEndian(self.buffer, (uint64_t)value, 1);
+	}
+}
+
+-(void)appendMarker:(uint8_t)marker count:(NSUInteger)count {
+	uint8_t byte = marker | (count < 15 ? (uint8_t)count : 0x0F);
+	[self.buffer appendBytes:&byte length:1];
+
+	if (count >= 15) {
+		[self appendInteger:(int64_t)count];
+	}
+}
+
+-(void)appendDouble:(double)value marker:(uint8_t)marker {
+	CFSwappedFloat64 swapped = CFConvertDoubleHostToSwapped(value);
+	[self.buffer appendBytes:&marker length:1];
+	[self.buffer appendBytes:&swapped length:sizeof(swapped)];
+}
+
+-(uint32_t)appendObject:(id)object {
+	if ([object isKindOfClass:[NSDictionary class]]) {
+		NSMutableData *refs = [NSMutableData dataWithCapacity:[object count] * 2 * kBinaryPropertyListObjectRefSize];
+		NSMutableData *valueRefs = [NSMutableData dataWithCapacity:[object count] * kBinaryPropertyListObjectRefSize];
+
+		for (NSString *key in object) {
+			NSNumber *keyRef = [self.keyRefs objectForKey:key];
+
+			if (keyRef == nil) {
+				keyRef = [NSNumber numberWithUnsignedInt:[self appendObject:[key description]]];
+				[self.keyRefs setObject:keyRef forKey:key];
+			}
+
+			RHAppendBigEndian(refs, [keyRef unsignedIntValue], kBinaryPropertyListObjectRefSize);
+			RHAppendBigEndian(valueRefs, [self appendObject:[object objectForKey:key]], kBinaryPropertyListObjectRefSize);
+		}
+
+		[refs appendData:valueRefs];
+
+		uint32_t ref = [self beginObject];
+		[self appendMarker:0xD0 count:[object count]];
+		[self.buffer appendData:refs];
+		return ref;
+	}
+
+	if ([object isKindOfClass:[NSArray class]]) {
+		NSMutableData *refs = [NSMutableData dataWithCapacity:[object count] * kBinaryPropertyListObjectRefSize];
+
+		for (id element in object) {
+			RHAppendBigEndian(refs, [self appendObject:element], kBinaryPropertyListObjectRefSize);
+		}
+
+		return [self appendArrayWithRefs:refs count:[object count]];
+	}
+
+	uint32_t ref = [self beginObject];
+
+	if ([object isKindOfClass:[NSString class]]) {
+		if ([object canBeConvertedToEncoding:NSASCIIStringEncoding]) {
+			NSData *data = [object dataUsingEncoding:NSASCIIStringEncoding];
+			[self appendMarker:0x50 count:[data length]];
+			[self.buffer appendData:data];
+		} else {
+			NSData *data = [object dataUsingEncoding:NSUTF16BigEndianStringEncoding];
+			[self appendMarker:0x60 count:[data length] / 2];
+			[self.buffer appendData:data];
+		}
+
+	} else if ([object isKindOfClass:[NSData class]]) {
+		[self appendMarker:0x40 count:[object length]];
+		[self.buffer appendData:object];
+
+	} else if ([object isKindOfClass:[NSDate class]]) {
+		[self appendDouble:[object timeIntervalSinceReferenceDate] marker:0x33];
+
+	} else if ([object isKindOfClass:[NSNumber class]]) {
+		const char *type = [object objCType];
+
+		if (CFGetTypeID((__bridge CFTypeRef)object) == CFBooleanGetTypeID()) {
+			[self.buffer appendBytes:([object boolValue] ? "\x09" : "\x08") length:1];
+		} else if ([object isKindOfClass:[NSDecimalNumber class]] || (strcmp(type, @encode(double)) == 0) || (strcmp(type, @encode(float)) == 0)) {
+			[self appendDouble:[object doubleValue] marker:0x23];
+		} else {
+			[self appendInteger:[object longLongValue]];
+		}
+	}
+
+	return ref;
+}
+
+-(uint32_t)appendArrayWithRefs:(NSData *)refs count:(NSUInteger)count {
+	uint32_t ref = [self beginObject];
+	[self appendMarker:0xA0 count:count];
+	[self.buffer appendData:refs];
+	return ref;
+}
+
+// The offset table grows with the number of values, so it is flushed in parts
+-(BOOL)appendTrailerWithTopObject:(uint32_t)topObject flush:(BOOL (^)(NSError **error))flush error:(NSError **)error {
+	uint64_t offsetTableOffset = self.flushedLength + [self.buffer length];
+	NSUInteger objectCount = [self.offsets length] / sizeof(uint64_t);
+	const uint64_t *offsets = [self.offsets bytes];
+
+	// Offsets only grow, so the last one determines the size of the entries
+	uint64_t lastOffset = (objectCount > 0) ? offsets[objectCount - 1] : 0;
+	uint8_t offsetSize = (lastOffset > UINT32_MAX) ? 8 : (lastOffset > UINT16_MAX) ? 4 : (lastOffset > UINT8_MAX) ? 2 : 1;
+
+	for (NSUInteger i = 0; i < objectCount; i++) {
+		RHAppendBigEndian(self.buffer, offsets[i], offsetSize);
+
+		if (([self.buffer length] >= kExporterFlushLength) && !flush(error)) {
+			return NO;
+		}
+	}
+
+	uint8_t sizes[8] = { 0, 0, 0, 0, 0, 0, offsetSize, kBinaryPropertyListObjectRefSize };
+	[self.buffer appendBytes:sizes length:sizeof(sizes)];
+	RHAppendBigEndian(self.buffer, objectCount, 8);
+	RHAppendBigEndian(self.buffer, topObject, 8);
+	RHAppendBigEndian(self.buffer, offsetTableOffset, 8);
+
+	return flush(error);
+}
+
+@end
+
+
+@interface RHExporter()
+@property (nonatomic, readwrite) Class entityClass;
+@property (nonatomic, strong) NSDateFormatter *dateFormatter;
+@property (nonatomic, strong) NSOutputStream *stream;
+@property (nonatomic, assign) RHExporterFormat format;
+@property (nonatomic, assign) unsigned long long bytesWritten;
+
+-(NSDictionary *)recordsWithObjectIDs:(NSArray *)objectIDs depth:(NSUInteger)depth context:(NSManagedObjectContext *)moc error:(NSError **)error;
+-(NSDictionary *)recordsWithObjectIDs:(NSArray *)objectIDs entity:(NSEntityDescription *)entity depth:(NSUInteger)depth context:(NSManagedObjectContext *)moc error:(NSError **)error;
+-(NSDictionary *)destinationIDsWithObjectIDs:(NSArray *)objectIDs relationship:(NSRelationshipDescription *)relationship context:(NSManagedObjectContext *)moc error:(NSError **)error;
+-(id)exportValue:(id)value attribute:(NSAttributeDescription *)attribute;
+-(BOOL)flushData:(NSMutableData *)data error:(NSError **)error;
+@end
+
+@implementation RHExporter
+
+-(id)initWithEntityClass:(Class)entityClass {
+	if (self=[super init]) {
+		self.entityClass = entityClass;
+		self.batchSize = kExporterBatchSize;
+
+		// The first format RHBulkLoader parses, so exports can be loaded again
+		self.dateFormatter = [NSDateFormatter new];
+		[self.dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+		[self.dateFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+		[self.dateFormatter setDateFormat:@"yyyy-MM-dd'T'HH:mm:ss.SSSZZZZZ"];
+	}
+	return self;
+}
+
+-(NSUInteger)exportToFileAtURL:(NSURL *)fileURL
+                        format:(RHExporterFormat)format
+                         error:(NSError **)error {
+
+	NSOutputStream *stream = [NSOutputStream outputStreamWithURL:fileURL append:NO];
+	[stream open];
+
+	if ((stream == nil) || ([stream streamStatus] == NSStreamStatusError)) {
+		if (error) {
+			*error = [stream streamError] ? [stream streamError] : [NSError errorWithDomain:RHManagedObjectErrorDomain
+																					  code:RHManagedObjectErrorFileNotWritable
+																				  userInfo:[NSDictionary dictionaryWithObject:fileURL forKey:NSURLErrorKey]];
+		}
+		return NSNotFound;
+	}
+
+	NSUInteger exported = [self exportToStream:stream format:format error:error];
+	[stream close];
+
+	return exported;
+}
+
+-(NSUInteger)exportToStream:(NSOutputStream *)stream
+                     format:(RHExporterFormat)format
+                      error:(NSError **)error {
+
+	NSError *exportError = nil;
+	NSManagedObjectContext *moc = [self.entityClass managedObjectContextForCurrentThreadWithError:&exportError];
+
+	// The object IDs are fetched one page per batch, so memory usage does not depend on the number of objects
+	RHFetchOptions *options = [self.entityClass fetchOptions];
+	options.predicate = self.predicate;
+	options.sortDescriptors = self.sortDescriptors;
+
+	NSFetchRequest *fetch = [NSFetchRequest new];
+	[fetch setEntity:[self.entityClass entityDescriptionWithError:&exportError]];
+	[options applyToFetchRequest:fetch];
+	[fetch setResultType:NSManagedObjectIDResultType];
+	[fetch setIncludesPendingChanges:NO];
+
+	if (exportError) {
+		if (error) {
+			*error = exportError;
+		}
+		return NSNotFound;
+	}
+
+	self.stream = stream;
+	self.format = format;
+	self.bytesWritten = 0;
+
+	NSUInteger batchSize = (self.batchSize > 0) ? self.batchSize : kExporterBatchSize;
+	NSUInteger exported = 0;
+	NSDate *start = [NSDate date];
+
+	RHBinaryPropertyListWriter *propertyListWriter = nil;
+	NSMutableData *recordRefs = nil;
+	NSMutableData *data = [NSMutableData data];
+
+	if (format == RHExporterFormatBinaryPropertyList) {
+		propertyListWriter = [RHBinaryPropertyListWriter new];
+		[propertyListWriter appendHeader];
+		// The top level array needs a reference to every record, which is the only part that grows with the number of objects
+		recordRefs = [NSMutableData data];
+		data = propertyListWriter.buffer;
+	} else if (format == RHExporterFormatJSON) {
+		[data appendBytes:"[" length:1];
+	}
+
+	[fetch setFetchLimit:batchSize];
+
+	for (NSUInteger offset = 0, batchCount = batchSize; (batchCount == batchSize) && (exportError == nil); offset += batchCount) {
+		@autoreleasepool {
+			[fetch setFetchOffset:offset];
+
+			NSArray *batch = [moc executeFetchRequest:fetch error:&exportError];
+			batchCount = [batch count];
+
+			if ((batch == nil) || (batchCount == 0)) {
+				break;
+			}
+
+			NSDictionary *records = [self recordsWithObjectIDs:batch depth:self.relationshipDepth context:moc error:&exportError];
+
+			for (NSManagedObjectID *objectID in batch) {
+				NSDictionary *record = [records objectForKey:objectID];
+
+				// Deleted since the object IDs were fetched
+				if ((record == nil) || (exportError != nil)) {
+					continue;
+				}
+
+				if (format == RHExporterFormatBinaryPropertyList) {
+					RHAppendBigEndian(recordRefs, [propertyListWriter appendObject:record], kBinaryPropertyListObjectRefSize);
+				} else {
+					NSData *json = [NSJSONSerialization dataWithJSONObject:record options:0 error:&exportError];
+
+					if (json == nil) {
+						continue;
+					}
+
+					if (format == RHExporterFormatJSON) {
+						[data appendBytes:(exported > 0) ? ",\n" : "\n" length:(exported > 0) ? 2 : 1];
+						[data appendData:json];
+					} else {
+						[data appendData:json];
+						[data appendBytes:"\n" length:1];
+					}
+				}
+
+				exported++;
+			}
+
+			if (exportError == nil) {
+				propertyListWriter.flushedLength += [data length];
+				[self flushData:data error:&exportError];
+			}
+
+			if ((exportError == nil) && self.progressBlock) {
+				self.progressBlock(exported, self.bytesWritten, exported / MAX(-[start timeIntervalSinceNow], 0.001));
+			}
+		}
+	}
+
+	if ((exportError == nil) && (format == RHExporterFormatBinaryPropertyList)) {
+		uint32_t topObject = [propertyListWriter appendArrayWithRefs:recordRefs count:exported];
+
+		[propertyListWriter appendTrailerWithTopObject:topObject flush:^BOOL(NSError **flushError) {
+			propertyListWriter.flushedLength += [propertyListWriter.buffer length];
+			return [self flushData:propertyListWriter.buffer error:flushError];
+		} error:&exportError];
+
+	} else if (exportError == nil) {
+		if (format == RHExporterFormatJSON) {
+			[data appendBytes:"\n]\n" length:3];
+		}
+
+		[self flushData:data error:&exportError];
+	}
+
+	self.stream = nil;
+
+	if (exportError) {
+		if (error) {
+			*error = exportError;
+		}
+		return NSNotFound;
+	}
+
+	return exported;
+}
+
+// Subentities have attributes of their own, so the objects are fetched per entity
+-(NSDictionary *)recordsWithObjectIDs:(NSArray *)objectIDs depth:(NSUInteger)depth context:(NSManagedObjectContext *)moc error:(NSError **)error {
+	NSMutableDictionary *objectIDsByEntity = [NSMutableDictionary dictionary];
+
+	for (NSManagedObjectID *objectID in objectIDs) {
+		NSMutableArray *entityObjectIDs = [objectIDsByEntity objectForKey:[[objectID entity] name]];
+
+		if (entityObjectIDs == nil) {
+			entityObjectIDs = [NSMutableArray array];
+			[objectIDsByEntity setObject:entityObjectIDs forKey:[[objectID entity] name]];
+		}
+
+		[entityObjectIDs addObject:objectID];
+	}
+
+	NSMutableDictionary *records = [NSMutableDictionary dictionaryWithCapacity:[objectIDs count]];
+
+	for (NSString *entityName in objectIDsByEntity) {
+		NSArray *entityObjectIDs = [objectIDsByEntity objectForKey:entityName];
+		NSDictionary *entityRecords = [self recordsWithObjectIDs:entityObjectIDs entity:[[entityObjectIDs lastObject] entity] depth:depth context:moc error:error];
+
+		if (entityRecords == nil) {
+			return nil;
+		}
+
+		[records addEntriesFromDictionary:entityRecords];
+	}
+
+	return records;
+}
+
+-(NSDictionary *)recordsWithObjectIDs:(NSArray *)objectIDs entity:(NSEntityDescription *)entity depth:(NSUInteger)depth context:(NSManagedObjectContext *)moc error:(NSError **)error {
+	NSExpressionDescription *objectIDDescription = [[NSExpressionDescription alloc] init];
+	[objectIDDescription setName:kExporterObjectIDKey];
+	[objectIDDescription setExpression:[NSExpression expressionForEvaluatedObject]];
+	[objectIDDescription setExpressionResultType:NSObjectIDAttributeType];
+
+	BOOL exportsRelationships = (depth > 0) || self.exportsRelationshipIDs;
+	NSMutableArray *attributes = [NSMutableArray array];
+	NSMutableArray *propertiesToFetch = [NSMutableArray arrayWithObject:objectIDDescription];
+
+	for (NSAttributeDescription *attribute in [[entity attributesByName] allValues]) {
+		if (![attribute isTransient]) {
+			[attributes addObject:attribute];
+			[propertiesToFetch addObject:attribute];
+		}
+	}
+
+	// To-one relationships are fetched as object IDs with the attributes
+	for (NSRelationshipDescription *relationship in [[entity relationshipsByName] allValues]) {
+		if (exportsRelationships && ![relationship isToMany] && ![relationship isTransient]) {
+			[propertiesToFetch addObject:relationship];
+		}
+	}
+
+	NSFetchRequest *fetch = [NSFetchRequest new];
+	[fetch setEntity:entity];
+	[fetch setPredicate:[NSPredicate predicateWithFormat:@"self IN %@", objectIDs]];
+	[fetch setIncludesSubentities:NO];
+	[fetch setResultType:NSDictionaryResultType];
+	[fetch setPropertiesToFetch:propertiesToFetch];
+	[fetch setIncludesPendingChanges:NO];
+
+	NSArray *rows = [moc executeFetchRequest:fetch error:error];
+
+	if (rows == nil) {
+		return nil;
+	}
+
+	// Relationship name -> source object ID -> destination object ID or array of object IDs
+	NSMutableDictionary *destinationIDsByRelationship = [NSMutableDictionary dictionary];
+	NSMutableArray *destinationIDs = [NSMutableArray array];
+
+	if (exportsRelationships) {
+		for (NSRelationshipDescription *relationship in [[entity relationshipsByName] allValues]) {
+			if ([relationship isTransient]) {
+				continue;
+			}
+
+			NSMutableDictionary *relationshipIDs = [NSMutableDictionary dictionary];
+
+			if ([relationship isToMany]) {
+				NSDictionary *toManyIDs = [self destinationIDsWithObjectIDs:objectIDs relationship:relationship context:moc error:error];
+
+				if (toManyIDs == nil) {
+					return nil;
+				}
+
+				[relationshipIDs addEntriesFromDictionary:toManyIDs];
+
+				for (NSArray *ids in [toManyIDs allValues]) {
+					[destinationIDs addObjectsFromArray:ids];
+				}
+			} else {
+				for (NSDictionary *row in rows) {
+					NSManagedObjectID *destinationID = [row objectForKey:[relationship name]];
+
+					if (destinationID) {
+						[relationshipIDs setObject:destinationID forKey:[row objectForKey:kExporterObjectIDKey]];
+						[destinationIDs addObject:destinationID];
+					}
+				}
+			}
+
+			[destinationIDsByRelationship setObject:relationshipIDs forKey:[relationship name]];
+		}
+	}
+
+	NSDictionary *nestedRecords = nil;
+
+	if ((depth > 0) && ([destinationIDs count] > 0)) {
+		nestedRecords = [self recordsWithObjectIDs:[[NSSet setWithArray:destinationIDs] allObjects] depth:depth - 1 context:moc error:error];
+
+		if (nestedRecords == nil) {
+			return nil;
+		}
+	}
+
+	NSMutableDictionary *records = [NSMutableDictionary dictionaryWithCapacity:[rows count]];
+
+	for (NSDictionary *row in rows) {
+		NSManagedObjectID *objectID = [row objectForKey:kExporterObjectIDKey];
+		NSMutableDictionary *record = [NSMutableDictionary dictionaryWithCapacity:[attributes count]];
+
+		for (NSAttributeDescription *attribute in attributes) {
+			id value = [self exportValue:[row objectForKey:[attribute name]] attribute:attribute];
+
+			if (value) {
+				[record setObject:value forKey:[attribute name]];
+			}
+		}
+
+		for (NSString *relationshipName in destinationIDsByRelationship) {
+			id relationshipIDs = [[destinationIDsByRelationship objectForKey:relationshipName] objectForKey:objectID];
+			NSMutableArray *values = [NSMutableArray array];
+
+			for (NSManagedObjectID *destinationID in ([relationshipIDs isKindOfClass:[NSArray class]] ? relationshipIDs : [NSArray arrayWithObjects:relationshipIDs, nil])) {
+				id value = nestedRecords ? [nestedRecords objectForKey:destinationID] : [[destinationID URIRepresentation] absoluteString];
+
+				if (value) {
+					[values addObject:value];
+				}
+			}
+
+			if ([relationshipIDs isKindOfClass:[NSArray class]]) {
+				[record setObject:values forKey:relationshipName];
+			} else if ([values count] > 0) {
+				[record setObject:[values lastObject] forKey:relationshipName];
+			}
+		}
+
+		if (self.objectIDKey) {
+			[record setObject:[[objectID URIRepresentation] absoluteString] forKey:self.objectIDKey];
+		}
+
+		[records setObject:record forKey:objectID];
+	}
+
+	return records;
+}
+
+// Returns source object ID -> array of destination object IDs, with an entry for every source object
+-(NSDictionary *)destinationIDsWithObjectIDs:(NSArray *)objectIDs relationship:(NSRelationshipDescription *)relationship context:(NSManagedObjectContext *)moc error:(NSError **)error {
+	NSMutableDictionary *destinationIDs = [NSMutableDictionary dictionaryWithCapacity:[objectIDs count]];
+
+	for (NSManagedObjectID *objectID in objectIDs) {
+		[destinationIDs setObject:[NSMutableArray array] forKey:objectID];
+	}
+
+	NSRelationshipDescription *inverse = [relationship inverseRelationship];
+
+	// A to-one inverse allows a single dictionary fetch of the destination objects for all source objects
+	if (inverse && ![inverse isToMany] && ![relationship isOrdered]) {
+		NSExpressionDescription *objectIDDescription = [[NSExpressionDescription alloc] init];
+		[objectIDDescription setName:kExporterObjectIDKey];
+		[objectIDDescription setExpression:[NSExpression expressionForEvaluatedObject]];
+		[objectIDDescription setExpressionResultType:NSObjectIDAttributeType];
+
+		NSFetchRequest *fetch = [NSFetchRequest new];
+		[fetch setEntity:[relationship destinationEntity]];
+		[fetch setPredicate:[NSPredicate predicateWithFormat:@"%K IN %@", [inverse name], objectIDs]];
+		[fetch setResultType:NSDictionaryResultType];
+		[fetch setPropertiesToFetch:[NSArray arrayWithObjects:inverse, objectIDDescription, nil]];
+		[fetch setIncludesPendingChanges:NO];
+
+		NSArray *rows = [moc executeFetchRequest:fetch error:error];
+
+		if (rows == nil) {
+			return nil;
+		}
+
+		for (NSDictionary *row in rows) {
+			[[destinationIDs objectForKey:[row objectForKey:[inverse name]]] addObject:[row objectForKey:kExporterObjectIDKey]];
+		}
+
+		return destinationIDs;
+	}
+
+	// Many-to-many and ordered relationships are read from the objects.  Prefetching fetches the relationship of the whole
+	// batch at once, instead of firing one fault per object.
+	NSFetchRequest *fetch = [NSFetchRequest new];
+	[fetch setEntity:[relationship entity]];
+	[fetch setPredicate:[NSPredicate predicateWithFormat:@"self IN %@", objectIDs]];
+	[fetch setIncludesSubentities:NO];
+	[fetch setRelationshipKeyPathsForPrefetching:[NSArray arrayWithObject:[relationship name]]];
+
+	NSArray *objects = [moc executeFetchRequest:fetch error:error];
+
+	if (objects == nil) {
+		return nil;
+	}
+
+	for (NSManagedObject *object in objects) {
+		id destinationObjects = [object valueForKey:[relationship name]];
+		NSArray *destinations = [relationship isOrdered] ? [destinationObjects array] : [destinationObjects allObjects];
+
+		[[destinationIDs objectForKey:[object objectID]] addObjectsFromArray:[destinations valueForKey:@"objectID"]];
+
+		// The prefetched destination objects are turned back into faults as well, so the batch does not stay in memory
+		for (NSManagedObject *destination in destinations) {
+			if (![destination hasChanges]) {
+				[moc refreshObject:destination mergeChanges:NO];
+			}
+		}
+
+		if (![object hasChanges]) {
+			[moc refreshObject:object mergeChanges:NO];
+		}
+	}
+
+	return destinationIDs;
+}
+
+-(id)exportValue:(id)value attribute:(NSAttributeDescription *)attribute {
+	if (value == nil || [value isKindOfClass:[NSNull class]]) {
+		return nil;
+	}
+
+	BOOL propertyList = (self.format == RHExporterFormatBinaryPropertyList);
+
+	switch ([attribute attributeType]) {
+		case NSBooleanAttributeType:
+			return [NSNumber numberWithBool:[value boolValue]];
+
+		case NSDoubleAttributeType:
+		case NSFloatAttributeType:
+			// JSON has no representation for NaN and infinity
+			return (propertyList || isfinite([value doubleValue])) ? value : nil;
+
+		case NSInteger16AttributeType:
+		case NSInteger32AttributeType:
+		case NSInteger64AttributeType:
+		case NSDecimalAttributeType:
+		case NSStringAttributeType:
+			return value;
+
+		case NSDateAttributeType:
+			return propertyList ? value : [self.dateFormatter stringFromDate:value];
+
+		case NSBinaryDataAttributeType:
+			return propertyList ? value : [value base64EncodedStringWithOptions:0];
+
+		default:
+			// NSUUIDAttributeType and NSURIAttributeType are not available before iOS 11
+			if ([value isKindOfClass:[NSUUID class]]) {
+				return [value UUIDString];
+			} else if ([value isKindOfClass:[NSURL class]]) {
+				return [value absoluteString];
+			}
+			return nil;
+	}
+}
+
+-(BOOL)flushData:(NSMutableData *)data error:(NSError **)error {
+	const uint8_t *bytes = [data bytes];
+	NSUInteger remaining = [data length];
+
+	while (remaining > 0) {
+		NSInteger written = [self.stream write:bytes maxLength:remaining];
+
+		if (written <= 0) {
+			if (error) {
+				*error = [self.stream streamError] ? [self.stream streamError] : [NSError errorWithDomain:RHManagedObjectErrorDomain code:RHManagedObjectErrorFileNotWritable userInfo:nil];
+			}
+			return NO;
+		}
+
+		bytes += written;
+		remaining -= written;
+		self.bytesWritten += written;
+	}
+
+	[data setLength:0];
+
+	return YES;
+}
+
+@end
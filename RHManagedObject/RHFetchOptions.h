@@ -0,0 +1,103 @@
+//
+//  RHFetchOptions.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHFetchOptions interface -
+/**
+ RHFetchOptions describes how objects are fetched from the persistent store. It wraps the options of an NSFetchRequest that are not covered by the predicate, sort descriptor and limit arguments of the RHManagedObject fetch methods. These options control how much of each object is loaded and when.
+
+ Use [RHManagedObject fetchOptions] on the entity subclass to obtain options initialized with the defaults of that subclass. RHFetchOptions is copied when passed to a background fetch, so it can be changed or reused afterwards.
+
+ */
+@interface RHFetchOptions : NSObject <NSCopying>
+
+/**
+ *  Returns fetch options with a predicate.
+ *
+ *  @param predicate The predicate that should match with the objects.
+ *
+ *  @return The fetch options.
+ */
++(instancetype)optionsWithPredicate:(NSPredicate *)predicate;
+
+/**
+ *  The predicate that should match with the objects. If nil all objects will be returned.
+ */
+@property (nonatomic, strong) NSPredicate *predicate;
+
+/**
+ *  An array of sort descriptors used to sort the fetched objects. If nil no additional sorting will occur.
+ */
+@property (nonatomic, strong) NSArray *sortDescriptors;
+
+/**
+ *  The maximum amount of objects to return. If 0 all objects will be returned.
+ */
+@property (nonatomic, assign) NSUInteger fetchLimit;
+
+/**
+ *  The number of objects to skip. Combined with fetchLimit this pages through the fetched objects.
+ */
+@property (nonatomic, assign) NSUInteger fetchOffset;
+
+/**
+ *  If greater than 0, the fetch returns a proxy array that loads the objects in batches of this size as they are accessed. Only the object IDs are fetched up front. Use this for long lists that are shown in a table or collection view.
+ */
+@property (nonatomic, assign) NSUInteger fetchBatchSize;
+
+/**
+ *  The names of the attributes to load (NSString or NSPropertyDescription). Other attributes are loaded by firing a fault when they are accessed. If nil all attributes are loaded.
+ */
+@property (nonatomic, strong) NSArray *propertiesToFetch;
+
+/**
+ *  Key paths of relationships (e.g., "department" or "department.manager") whose destination objects are fetched together with the objects. This avoids firing one fault per object when the relationship is accessed.
+ */
+@property (nonatomic, strong) NSArray *relationshipKeyPathsForPrefetching;
+
+/**
+ *  Whether or not the fetched objects are returned as faults. The property values are still loaded into the row cache if includesPropertyValues is YES. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL returnsObjectsAsFaults;
+
+/**
+ *  Whether or not the property values are loaded with the objects. Set this to NO if only the objects (e.g., to delete them) or their IDs are needed. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL includesPropertyValues;
+
+/**
+ *  Whether or not subentities are included in the fetched objects. Defaults to YES, or to shouldFetchRequestsReturnSubentities if created with [RHManagedObject fetchOptions].
+ */
+@property (nonatomic, assign) BOOL includesSubentities;
+
+/**
+ *  Applies the options to a fetch request.
+ *
+ *  @param fetchRequest The fetch request.
+ */
+-(void)applyToFetchRequest:(NSFetchRequest *)fetchRequest;
+
+@end
@@ -0,0 +1,95 @@
+//
+//  RHFetchOptions.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+
+#import "RHFetchOptions.h"
+
+@implementation RHFetchOptions
+
++(instancetype)optionsWithPredicate:(NSPredicate *)predicate {
+	RHFetchOptions *options = [[self alloc] init];
+	options.predicate = predicate;
+	return options;
+}
+
+-(id)init {
+	if (self=[super init]) {
+		self.returnsObjectsAsFaults = YES;
+		self.includesPropertyValues = YES;
+		self.includesSubentities = YES;
+	}
+	return self;
+}
+
+-(id)copyWithZone:(NSZone *)zone {
+	RHFetchOptions *options = [[[self class] allocWithZone:zone] init];
+
+	options.predicate = self.predicate;
+	options.sortDescriptors = self.sortDescriptors;
+	options.fetchLimit = self.fetchLimit;
+	options.fetchOffset = self.fetchOffset;
+	options.fetchBatchSize = self.fetchBatchSize;
+	options.propertiesToFetch = self.propertiesToFetch;
+	options.relationshipKeyPathsForPrefetching = self.relationshipKeyPathsForPrefetching;
+	options.returnsObjectsAsFaults = self.returnsObjectsAsFaults;
+	options.includesPropertyValues = self.includesPropertyValues;
+	options.includesSubentities = self.includesSubentities;
+
+	return options;
+}
+
+-(void)applyToFetchRequest:(NSFetchRequest *)fetchRequest {
+	if (self.predicate) {
+		[fetchRequest setPredicate:self.predicate];
+	}
+
+	if (self.sortDescriptors) {
+		[fetchRequest setSortDescriptors:self.sortDescriptors];
+	}
+
+	if (self.fetchLimit > 0) {
+		[fetchRequest setFetchLimit:self.fetchLimit];
+	}
+
+	if (self.fetchOffset > 0) {
+		[fetchRequest setFetchOffset:self.fetchOffset];
+	}
+
+	if (self.fetchBatchSize > 0) {
+		[fetchRequest setFetchBatchSize:self.fetchBatchSize];
+	}
+
+	if (self.propertiesToFetch) {
+		[fetchRequest setPropertiesToFetch:self.propertiesToFetch];
+	}
+
+	if (self.relationshipKeyPathsForPrefetching) {
+		[fetchRequest setRelationshipKeyPathsForPrefetching:self.relationshipKeyPathsForPrefetching];
+	}
+
+	[fetchRequest setReturnsObjectsAsFaults:self.returnsObjectsAsFaults];
+	[fetchRequest setIncludesPropertyValues:self.includesPropertyValues];
+	[fetchRequest setIncludesSubentities:self.includesSubentities];
+}
+
+@end
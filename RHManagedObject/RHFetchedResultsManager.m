@@ -24,6 +24,7 @@
 
 #import "RHFetchedResultsManager.h"
 #import "RHManagedObject.h"
+#import "RHManagedObjectContextManager.h"
 
 static UITableViewRowAnimation insertRowAnimation = UITableViewRowAnimationAutomatic;
 static UITableViewRowAnimation deleteRowAnimation = UITableViewRowAnimationAutomatic;
@@ -71,6 +72,14 @@ static UITableViewRowAnimation deleteRowAnimation = UITableViewRowAnimationAutom
     if (_fetchedResultsController == nil) {
         
         Class classFromString = NSClassFromString(self.entityClass);
+        NSError *error = nil;
+        NSManagedObjectContext *moc = [classFromString managedObjectContextForCurrentThreadWithError:&error];
+        
+        // Not kept, so the next access tries again once the stores are loaded
+        if (moc == nil) {
+            NSLog(@"Unresolved error: %@", [error localizedDescription]);
+            return nil;
+        }
         
         NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] init];
         [fetchRequest setEntity:[classFromString entityDescriptionWithError:nil]];
@@ -78,12 +87,12 @@ static UITableViewRowAnimation deleteRowAnimation = UITableViewRowAnimationAutom
         [fetchRequest setSortDescriptors:[NSArray arrayWithObjects:self.sortDescriptor, nil]];
         
         self.fetchedResultsController = [[NSFetchedResultsController alloc] initWithFetchRequest:fetchRequest
-                                                                            managedObjectContext:[classFromString managedObjectContextForCurrentThreadWithError:nil]
+                                                                            managedObjectContext:moc
                                                                               sectionNameKeyPath:self.sectionNameKeyPath
                                                                                        cacheName:nil];
         _fetchedResultsController.delegate = self;
-        
-        NSError *error = nil;
+
+        [RHManagedObjectContextManager registerFetchedResultsController:_fetchedResultsController];
         
         if (![_fetchedResultsController performFetch:&error]) {
             NSLog(@"Unresolved error: %@", [error localizedDescription]);
@@ -0,0 +1,100 @@
+//
+//  RHIdentityIndex.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHIdentityIndex interface -
+/**
+ RHIdentityIndex maps the values of a unique key attribute (e.g., the ID of an object on a server) to the object IDs of an entity and its subentities, so objects can be looked up by key without accessing the persistent store. The index is loaded with a single fetch of the keys and object IDs the first time it is used, and is then kept up to date by RHManagedObjectContextManager from the saved changes. RHIdentityIndex is thread-safe.
+
+ */
+@interface RHIdentityIndex : NSObject
+
+/**
+ *  Initialize an RHIdentityIndex instance.
+ *
+ *  @param entity The entity of the indexed objects.
+ *  @param key    The name of the unique key attribute.
+ *
+ *  @return An initialized RHIdentityIndex object.
+ */
+-(id)initWithEntity:(NSEntityDescription *)entity key:(NSString *)key;
+
+@property (nonatomic, readonly) NSEntityDescription *entity;
+@property (nonatomic, readonly) NSString *key;
+
+/**
+ *  Whether or not the keys and object IDs have been loaded.
+ */
+@property (readonly, getter=isLoaded) BOOL loaded;
+
+/**
+ *  Loads the keys and object IDs from the persistent store, unless they are loaded already. Changes recorded while loading take precedence over the fetched values. If the index is invalidated while the keys are fetched, the fetch is repeated a few times before this fails with an RHManagedObjectErrorIndexNotLoaded error.
+ *
+ *  @param moc   The managed object context used for the fetch.
+ *  @param error If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return YES if the index is loaded.
+ */
+-(BOOL)loadWithContext:(NSManagedObjectContext *)moc error:(NSError **)error;
+
+/**
+ *  Returns the object ID for a key.
+ *
+ *  @param key The value of the unique key attribute.
+ *
+ *  @return The object ID or nil if no object has this key.
+ */
+-(NSManagedObjectID *)objectIDForKey:(id)key;
+
+/**
+ *  Returns the object IDs for several keys.
+ *
+ *  @param keys The values of the unique key attribute.
+ *
+ *  @return A dictionary with the keys that were found as keys and the object IDs as values.
+ */
+-(NSDictionary *)objectIDsForKeys:(id<NSFastEnumeration>)keys;
+
+/**
+ *  Records the key of a saved object, replacing its previous key.
+ *
+ *  @param objectID The object ID of the saved object.
+ *  @param key      The value of the unique key attribute. If nil the object is removed from the index.
+ */
+-(void)setObjectID:(NSManagedObjectID *)objectID forKey:(id)key;
+
+/**
+ *  Removes a deleted object from the index.
+ *
+ *  @param objectID The object ID of the deleted object.
+ */
+-(void)removeObjectID:(NSManagedObjectID *)objectID;
+
+/**
+ *  Removes all keys, so the index is loaded again the next time it is used.
+ */
+-(void)invalidate;
+
+@end
@@ -0,0 +1,190 @@
+//
+//  RHIdentityIndex.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHIdentityIndex.h"
+#import "RHManagedObjectContextManager.h"
+
+#define kObjectIDKey @"objectID"
+#define kLoadAttempts 3 // Number of fetches before loading gives up on an index that keeps being invalidated
+
+@interface RHIdentityIndex()
+@property (nonatomic, strong) NSMutableDictionary *objectIDsByKey;
+@property (nonatomic, strong) NSMutableDictionary *keysByObjectID;
+@property (nonatomic, strong) NSMutableSet *changedObjectIDs;
+@property (nonatomic, assign) NSUInteger generation;
+@property (readwrite, getter=isLoaded) BOOL loaded;
+@end
+
+@implementation RHIdentityIndex
+
+-(id)initWithEntity:(NSEntityDescription *)entity key:(NSString *)key {
+	if (self=[super init]) {
+		_entity = entity;
+		_key = [key copy];
+		self.objectIDsByKey = [NSMutableDictionary dictionary];
+		self.keysByObjectID = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+-(BOOL)loadWithContext:(NSManagedObjectContext *)moc error:(NSError **)error {
+	NSExpressionDescription *objectIDDescription = [[NSExpressionDescription alloc] init];
+	[objectIDDescription setName:kObjectIDKey];
+	[objectIDDescription setExpression:[NSExpression expressionForEvaluatedObject]];
+	[objectIDDescription setExpressionResultType:NSObjectIDAttributeType];
+
+	NSFetchRequest *fetch = [NSFetchRequest new];
+	[fetch setEntity:self.entity];
+	[fetch setPredicate:[NSPredicate predicateWithFormat:@"%K != nil", self.key]];
+	[fetch setResultType:NSDictionaryResultType];
+	[fetch setPropertiesToFetch:[NSArray arrayWithObjects:self.key, objectIDDescription, nil]];
+	[fetch setIncludesPendingChanges:NO];
+
+	for (NSUInteger attempt = 0; attempt < kLoadAttempts; attempt++) {
+		NSUInteger generation = 0;
+
+		@synchronized(self) {
+			if (self.loaded) {
+				return YES;
+			}
+
+			// Changes saved while the fetch runs are newer than the fetched rows
+			if (self.changedObjectIDs == nil) {
+				self.changedObjectIDs = [NSMutableSet set];
+			}
+
+			generation = self.generation;
+		}
+
+		NSArray *rows = [moc executeFetchRequest:fetch error:error];
+
+		if (rows == nil) {
+			return NO;
+		}
+
+		@synchronized(self) {
+			// Another thread finished loading first
+			if (self.loaded) {
+				return YES;
+			}
+
+			// The index was invalidated while the fetch ran, so the rows may be outdated
+			if (generation != self.generation) {
+				continue;
+			}
+
+			for (NSDictionary *row in rows) {
+				NSManagedObjectID *objectID = [row objectForKey:kObjectIDKey];
+
+				if (![self.changedObjectIDs containsObject:objectID]) {
+					[self.objectIDsByKey setObject:objectID forKey:[row objectForKey:self.key]];
+					[self.keysByObjectID setObject:[row objectForKey:self.key] forKey:objectID];
+				}
+			}
+
+			self.changedObjectIDs = nil;
+			self.loaded = YES;
+		}
+
+		return YES;
+	}
+
+	if (error) {
+		*error = [NSError errorWithDomain:RHManagedObjectErrorDomain
+									 code:RHManagedObjectErrorIndexNotLoaded
+								 userInfo:[NSDictionary dictionaryWithObject:@"The identity index was invalidated while it was being loaded." forKey:NSLocalizedDescriptionKey]];
+	}
+
+	return NO;
+}
+
+-(NSManagedObjectID *)objectIDForKey:(id)key {
+	if (key == nil) {
+		return nil;
+	}
+
+	@synchronized(self) {
+		return [self.objectIDsByKey objectForKey:key];
+	}
+}
+
+-(NSDictionary *)objectIDsForKeys:(id<NSFastEnumeration>)keys {
+	NSMutableDictionary *objectIDs = [NSMutableDictionary dictionary];
+
+	@synchronized(self) {
+		for (id key in keys) {
+			NSManagedObjectID *objectID = [self.objectIDsByKey objectForKey:key];
+
+			if (objectID) {
+				[objectIDs setObject:objectID forKey:key];
+			}
+		}
+	}
+
+	return objectIDs;
+}
+
+// Until the index is loaded only the changed object IDs are recorded; the fetch picks up the rest
+-(void)setObjectID:(NSManagedObjectID *)objectID forKey:(id)key {
+	@synchronized(self) {
+		[self.changedObjectIDs addObject:objectID];
+
+		id previousKey = [self.keysByObjectID objectForKey:objectID];
+
+		// The key may have been taken over by another object since
+		if (previousKey) {
+			if ([[self.objectIDsByKey objectForKey:previousKey] isEqual:objectID]) {
+				[self.objectIDsByKey removeObjectForKey:previousKey];
+			}
+			[self.keysByObjectID removeObjectForKey:objectID];
+		}
+
+		if (key && (self.loaded || self.changedObjectIDs)) {
+			// An object that had this key no longer maps back to it
+			NSManagedObjectID *previousObjectID = [self.objectIDsByKey objectForKey:key];
+
+			if (previousObjectID && ![previousObjectID isEqual:objectID]) {
+				[self.keysByObjectID removeObjectForKey:previousObjectID];
+			}
+
+			[self.objectIDsByKey setObject:objectID forKey:key];
+			[self.keysByObjectID setObject:key forKey:objectID];
+		}
+	}
+}
+
+-(void)removeObjectID:(NSManagedObjectID *)objectID {
+	[self setObjectID:objectID forKey:nil];
+}
+
+-(void)invalidate {
+	@synchronized(self) {
+		[self.objectIDsByKey removeAllObjects];
+		[self.keysByObjectID removeAllObjects];
+		self.changedObjectIDs = nil;
+		self.loaded = NO;
+		self.generation++;
+	}
+}
+
+@end
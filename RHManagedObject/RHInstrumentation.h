@@ -0,0 +1,156 @@
+//
+//  RHInstrumentation.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+
+typedef enum {
+	RHInstrumentationOperationFetch,
+	RHInstrumentationOperationCount,
+	RHInstrumentationOperationAggregate,
+	RHInstrumentationOperationCommit,
+	RHInstrumentationOperationMerge,
+	RHInstrumentationOperationContextCreation
+} RHInstrumentationOperation;
+
+#define kHistogramBucketCount 24 // Bucket i counts durations below 2^i microseconds, the last bucket everything above
+#define kHistogramWindow 60.0 // Default number of seconds after which a histogram starts a new window
+
+#import <CoreData/CoreData.h>
+
+@class RHInstrumentationEvent;
+
+typedef void (^RHInstrumentationBlock)(RHInstrumentationEvent *event);
+
+
+#pragma mark - RHInstrumentationEvent interface -
+/**
+ RHInstrumentationEvent describes a single operation performed by RHManagedObject or RHManagedObjectContextManager. Events are only created while an instrumentation block is set or histograms are collected on the managed object context manager.
+
+ */
+@interface RHInstrumentationEvent : NSObject
+
+/**
+ *  The type of operation.
+ */
+@property (nonatomic, assign) RHInstrumentationOperation operation;
+
+/**
+ *  The name of the entity, or nil for the creation of a managed object context. Commits and merges are reported once for each entity with changes.
+ */
+@property (nonatomic, strong) NSString *entityName;
+
+/**
+ *  The format of the predicate, or nil if no predicate was used.
+ */
+@property (nonatomic, strong) NSString *predicateFormat;
+
+/**
+ *  The number of results for fetch, count and aggregate operations, or the number of changed objects of the entity for commit and merge operations.
+ */
+@property (nonatomic, assign) NSUInteger resultCount;
+
+/**
+ *  The time in seconds the operation took.
+ */
+@property (nonatomic, assign) NSTimeInterval duration;
+
+/**
+ *  The name of the thread the operation was performed on.
+ */
+@property (nonatomic, strong) NSString *threadName;
+
+/**
+ *  Whether or not the operation was performed on the main thread.
+ */
+@property (nonatomic, assign) BOOL mainThread;
+
+/**
+ *  The managed object context the operation was performed in. This must only be accessed from the thread of the managed object context.
+ */
+@property (nonatomic, weak) NSManagedObjectContext *managedObjectContext;
+
+/**
+ *  Returns the name of an operation, e.g., "fetch".
+ *
+ *  @param operation The operation.
+ *
+ *  @return The name of the operation.
+ */
++(NSString *)nameOfOperation:(RHInstrumentationOperation)operation;
+
+@end
+
+
+#pragma mark - RHInstrumentationHistogram interface -
+/**
+ RHInstrumentationHistogram summarizes the durations of one operation type for one entity. It covers the current window and the one before it, so it rolls over with time rather than growing forever.
+
+ */
+@interface RHInstrumentationHistogram : NSObject <NSCopying>
+
+/**
+ *  Initialize an RHInstrumentationHistogram instance.
+ *
+ *  @param window The number of seconds after which a new window is started.
+ *
+ *  @return An initialized RHInstrumentationHistogram object.
+ */
+-(id)initWithWindow:(NSTimeInterval)window;
+
+/**
+ *  The number of recorded operations.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ *  The total time in seconds of the recorded operations.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+
+/**
+ *  The longest time in seconds of a recorded operation.
+ */
+@property (nonatomic, readonly) NSTimeInterval maximumDuration;
+
+/**
+ *  The total number of results of the recorded operations.
+ */
+@property (nonatomic, readonly) NSUInteger totalResultCount;
+
+/**
+ *  Records the duration of an operation.
+ *
+ *  @param duration    The time in seconds the operation took.
+ *  @param resultCount The number of results of the operation.
+ */
+-(void)recordDuration:(NSTimeInterval)duration resultCount:(NSUInteger)resultCount;
+
+/**
+ *  Returns an estimate of a percentile of the recorded durations. The estimate is the upper bound of the bucket the percentile falls in, so it is accurate within a factor of 2.
+ *
+ *  @param percentile The percentile between 0 and 100, e.g., 95.
+ *
+ *  @return The duration in seconds.
+ */
+-(NSTimeInterval)durationAtPercentile:(double)percentile;
+
+@end
@@ -0,0 +1,202 @@
+//
+//  RHInstrumentation.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+
+#import "RHInstrumentation.h"
+
+@implementation RHInstrumentationEvent
+
++(NSString *)nameOfOperation:(RHInstrumentationOperation)operation {
+	switch (operation) {
+		case RHInstrumentationOperationFetch:
+			return @"fetch";
+		case RHInstrumentationOperationCount:
+			return @"count";
+		case RHInstrumentationOperationAggregate:
+			return @"aggregate";
+		case RHInstrumentationOperationCommit:
+			return @"commit";
+		case RHInstrumentationOperationMerge:
+			return @"merge";
+		case RHInstrumentationOperationContextCreation:
+			return @"contextCreation";
+	}
+
+	return nil;
+}
+
+-(NSString *)description {
+	return [NSString stringWithFormat:@"<%@ %@ %@ (%@) results=%lu duration=%.3fms thread=%@>",
+			NSStringFromClass([self class]),
+			[RHInstrumentationEvent nameOfOperation:self.operation],
+			self.entityName ? self.entityName : @"-",
+			self.predicateFormat ? self.predicateFormat : @"",
+			(unsigned long)self.resultCount,
+			self.duration * 1000,
+			self.mainThread ? @"main" : self.threadName];
+}
+
+@end
+
+
+@interface RHInstrumentationHistogram() {
+	NSUInteger currentBuckets[kHistogramBucketCount];
+	NSUInteger previousBuckets[kHistogramBucketCount];
+}
+@property (nonatomic, assign) NSTimeInterval window;
+@property (nonatomic, assign) CFAbsoluteTime windowStart;
+@property (nonatomic, assign) NSUInteger currentCount;
+@property (nonatomic, assign) NSUInteger previousCount;
+@property (nonatomic, assign) NSTimeInterval currentDuration;
+@property (nonatomic, assign) NSTimeInterval previousDuration;
+@property (nonatomic, assign) NSTimeInterval currentMaximumDuration;
+@property (nonatomic, assign) NSTimeInterval previousMaximumDuration;
+@property (nonatomic, assign) NSUInteger currentResultCount;
+@property (nonatomic, assign) NSUInteger previousResultCount;
+-(void)rollWindow;
+@end
+
+@implementation RHInstrumentationHistogram
+
+-(id)initWithWindow:(NSTimeInterval)window {
+	if (self=[super init]) {
+		self.window = window;
+		self.windowStart = CFAbsoluteTimeGetCurrent();
+	}
+	return self;
+}
+
+-(id)copyWithZone:(NSZone *)zone {
+	RHInstrumentationHistogram *histogram = [[[self class] allocWithZone:zone] initWithWindow:self.window];
+
+	histogram.windowStart = self.windowStart;
+	histogram.currentCount = self.currentCount;
+	histogram.previousCount = self.previousCount;
+	histogram.currentDuration = self.currentDuration;
+	histogram.previousDuration = self.previousDuration;
+	histogram.currentMaximumDuration = self.currentMaximumDuration;
+	histogram.previousMaximumDuration = self.previousMaximumDuration;
+	histogram.currentResultCount = self.currentResultCount;
+	histogram.previousResultCount = self.previousResultCount;
+
+	memcpy(histogram->currentBuckets, currentBuckets, sizeof(currentBuckets));
+	memcpy(histogram->previousBuckets, previousBuckets, sizeof(previousBuckets));
+
+	return histogram;
+}
+
+// Once a window has passed the current values become the previous ones; after two windows both are cleared
+-(void)rollWindow {
+	CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+	if (now - self.windowStart < self.window) {
+		return;
+	}
+
+	if (now - self.windowStart < 2 * self.window) {
+		memcpy(previousBuckets, currentBuckets, sizeof(currentBuckets));
+		self.previousCount = self.currentCount;
+		self.previousDuration = self.currentDuration;
+		self.previousMaximumDuration = self.currentMaximumDuration;
+		self.previousResultCount = self.currentResultCount;
+	} else {
+		memset(previousBuckets, 0, sizeof(previousBuckets));
+		self.previousCount = 0;
+		self.previousDuration = 0;
+		self.previousMaximumDuration = 0;
+		self.previousResultCount = 0;
+	}
+
+	memset(currentBuckets, 0, sizeof(currentBuckets));
+	self.currentCount = 0;
+	self.currentDuration = 0;
+	self.currentMaximumDuration = 0;
+	self.currentResultCount = 0;
+	self.windowStart = now;
+}
+
+-(void)recordDuration:(NSTimeInterval)duration resultCount:(NSUInteger)resultCount {
+	[self rollWindow];
+
+	NSUInteger bucket = 0;
+	double microseconds = duration * 1e6;
+
+	while ((bucket < kHistogramBucketCount - 1) && (microseconds >= (double)(1 << bucket))) {
+		bucket++;
+	}
+
+	currentBuckets[bucket]++;
+	self.currentCount++;
+	self.currentDuration += duration;
+	self.currentMaximumDuration = MAX(self.currentMaximumDuration, duration);
+	self.currentResultCount += resultCount;
+}
+
+-(NSUInteger)count {
+	return self.currentCount + self.previousCount;
+}
+
+-(NSTimeInterval)totalDuration {
+	return self.currentDuration + self.previousDuration;
+}
+
+-(NSTimeInterval)maximumDuration {
+	return MAX(self.currentMaximumDuration, self.previousMaximumDuration);
+}
+
+-(NSUInteger)totalResultCount {
+	return self.currentResultCount + self.previousResultCount;
+}
+
+-(NSTimeInterval)durationAtPercentile:(double)percentile {
+	NSUInteger count = [self count];
+
+	if (count == 0) {
+		return 0;
+	}
+
+	NSUInteger rank = (NSUInteger)ceil(count * MIN(MAX(percentile, 0), 100) / 100.0);
+	NSUInteger seen = 0;
+
+	for (NSUInteger bucket = 0; bucket < kHistogramBucketCount; bucket++) {
+		seen += currentBuckets[bucket] + previousBuckets[bucket];
+
+		if ((seen >= rank) && (seen > 0)) {
+			return (bucket == kHistogramBucketCount - 1) ? [self maximumDuration] : (double)(1 << bucket) / 1e6;
+		}
+	}
+
+	return [self maximumDuration];
+}
+
+-(NSString *)description {
+	return [NSString stringWithFormat:@"<%@ count=%lu total=%.3fms p50=%.3fms p95=%.3fms max=%.3fms>",
+			NSStringFromClass([self class]),
+			(unsigned long)[self count],
+			[self totalDuration] * 1000,
+			[self durationAtPercentile:50] * 1000,
+			[self durationAtPercentile:95] * 1000,
+			[self maximumDuration] * 1000];
+}
+
+@end
@@ -26,14 +26,27 @@ typedef enum {
     RHAggregateMax,
 	RHAggregateMin,
 	RHAggregateAverage,
-	RHAggregateSum
+	RHAggregateSum,
+	RHAggregateCount,
+	RHAggregateCountDistinct
 } RHAggregate;
 
+typedef enum {
+	RHContextTransferExisting,   // existingObjectWithID:error: per object, may fetch each object individually
+	RHContextTransferFaults,     // objectWithID: per object, returns faults without accessing the store
+	RHContextTransferBatchFetch  // a single fetch per entity for all objects that are not registered yet
+} RHContextTransferMode;
+
+#define RHDistinctValueCountKey @"count"
+
 typedef void (^RHDidUpdateBlock)(void);
 typedef void (^RHDidDeleteBlock)(void);
 
 #import <CoreData/CoreData.h>
+#import "RHFetchOptions.h"
 @class RHManagedObjectContextManager;
+@class RHAggregateDescription;
+@class RHMaterializedAggregate;
 
 
 #pragma mark - RHManagedObject interface -
@@ -89,6 +102,20 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 +(BOOL)shouldFetchRequestsReturnSubentities;
 
+/**
+ *  Returns new fetch options initialized with the defaults of this entity.
+ *
+ *  @return The fetch options.
+ */
++(RHFetchOptions *)fetchOptions;
+
+/**
+ *  Return the name of the attribute that uniquely identifies an object (e.g., the ID of the object on a server) to enable getWithKey:error: and objectsWithKeys:error:. Override this in the RHManagedObject subclass. The values of the attribute should be unique among the objects of the entity and its subentities.
+ *
+ *  @return The name of the unique key attribute, or nil (the default) if the entity has none.
+ */
++(NSString *)uniqueKeyProperty;
+
 
 
 #pragma mark - Adding Objects to the Persistent Store
@@ -119,6 +146,35 @@ typedef void (^RHDidDeleteBlock)(void);
 +(id)newOrExistingEntityWithPredicate:(NSPredicate *)predicate
                                 error:(NSError **)error;
 
+/**
+ *  Imports a collection of records, inserting new objects or updating existing objects in place, in batches of 500 records.
+ *
+ *  @param records   A collection of dictionaries (e.g., an NSArray or an NSEnumerator) with the names of the attributes as keys.
+ *  @param uniqueKey The name of the attribute that uniquely identifies an object.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of imported records. If an error occurred this will return NSNotFound.
+ *  @see importRecords:uniqueKey:batchSize:error:
+ */
++(NSUInteger)importRecords:(id<NSFastEnumeration>)records
+                 uniqueKey:(NSString *)uniqueKey
+                     error:(NSError **)error;
+
+/**
+ *  Imports a collection of records, inserting new objects or updating existing objects in place. Unlike calling newOrExistingEntityWithPredicate:error: for each record, existing objects are resolved with a single fetch per batch. The records are imported with a temporary managed object context (see performWithTemporaryContext:error:), so the current thread's managed object context and its pending changes are left untouched. Each batch is committed, after which the imported objects are turned back into faults, such that memory usage stays flat regardless of the number of records. Keys that are not attributes of the entity are ignored, as are values that did not change.
+ *
+ *  @param records   A collection of dictionaries (e.g., an NSArray or an NSEnumerator) with the names of the attributes as keys. NSNull values are stored as nil.
+ *  @param uniqueKey The name of the attribute that uniquely identifies an object. Records without a value for this key are always inserted.
+ *  @param batchSize The number of records to import per batch. If 0, a batch size of 500 is used.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of imported records. If an error occurred this will return NSNotFound; batches imported before the error remain committed.
+ */
++(NSUInteger)importRecords:(id<NSFastEnumeration>)records
+                 uniqueKey:(NSString *)uniqueKey
+                 batchSize:(NSUInteger)batchSize
+                     error:(NSError **)error;
+
 /**
  *  Inserts a shallow copy of this Managed Object in the current thread's managed object context. This only copies attributes, not relationships. A commit is still required to add the object to the persistent store.
  *
@@ -153,7 +209,7 @@ typedef void (^RHDidDeleteBlock)(void);
 +(NSUInteger)deleteAllWithError:(NSError **)error;
 
 /**
- *  Deletes objects for this entity from the managed object context, that match a specific predicate. A commit is still required to remove the objects from the persistent store.
+ *  Deletes objects for this entity from the managed object context, that match a specific predicate. A commit is still required to remove the objects from the persistent store. If shouldDeleteInPersistentStore returns YES, the objects are deleted directly in the persistent store as in batchDeleteWithPredicate:error:.
  *
  *  @param predicate The predicate that should match with the objects. If nil all objects will be returned.
  *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
@@ -163,6 +219,25 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 +(NSUInteger)deleteWithPredicate:(NSPredicate *)predicate error:(NSError **)error;
 
+/**
+ *  Return whether or not deleteWithPredicate:error: and deleteAllWithError: should delete the objects directly in the persistent store. Override this in the RHManagedObject subclass to return YES for entities with a large number of objects (e.g., log tables). Defaults to NO.
+ *
+ *  @return Whether or not to delete objects in the persistent store by default.
+ *  @see batchDeleteWithPredicate:error:
+ */
++(BOOL)shouldDeleteInPersistentStore;
+
+/**
+ *  Deletes objects for this entity that match a specific predicate directly in the persistent store, without fetching them into a managed object context. No commit is required. The deleted objects are merged into the main thread managed object context and the managed object contexts of the other threads, such that didDelete is called for objects that are in use. Validation and unsaved changes in the managed object context are not taken into account. If the persistent store does not support batch requests the objects are deleted from the managed object context as in deleteWithPredicate:error:.
+ *
+ *  @param predicate The predicate that should match with the objects. If nil all objects will be deleted.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return Returns the number of objects that were deleted.
+ *  @see mergeStoreChanges:
+ */
++(NSUInteger)batchDeleteWithPredicate:(NSPredicate *)predicate error:(NSError **)error;
+
 /**
  *  Deletes the persistent store for the data model this entity belongs to.
  *
@@ -185,6 +260,28 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 +(NSError *)commit;
 
+/**
+ *  Attempts to commit unsaved changes to the persistent store this entity belongs to right away, even if the managed object context manager defers commits.
+ *
+ *  @return If an error occurs, this returns an NSError object that describes the problem, otherwise nil.
+ *  @see [RHManagedObjectContextManager defersCommits]
+ */
++(NSError *)commitImmediately;
+
+/**
+ *  Updates properties of the objects for this entity that match a specific predicate directly in the persistent store, without fetching them into a managed object context. No commit is required. The updated objects are refreshed in the main thread managed object context and the managed object contexts of the other threads, such that didUpdate is called for objects that are registered in those contexts. Validation is not performed. If the persistent store does not support batch requests (e.g., an in-memory store), the objects are fetched into a temporary managed object context, updated and committed right away, so the result is the same; pending changes of the current thread's managed object context are not committed.
+ *
+ *  @param predicate          The predicate that should match with the objects. If nil all objects will be updated.
+ *  @param propertiesToUpdate A dictionary with the names of the attributes as keys and the new values as values. A value can also be an NSExpression, which is evaluated for each object (e.g., to increment a counter).
+ *  @param error              If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return An array containing the NSManagedObjectID instances of the updated objects, or nil if an error occurs.
+ *  @see mergeStoreChanges:
+ */
++(NSArray *)updateWithPredicate:(NSPredicate *)predicate
+             propertiesToUpdate:(NSDictionary *)propertiesToUpdate
+                          error:(NSError **)error;
+
 /**
  *  This method gets called every time this updated object gets merged in the main thread managed object context. By default this method will execute the didUpdateBlock.
  *
@@ -239,6 +336,41 @@ typedef void (^RHDidDeleteBlock)(void);
        sortDescriptor:(NSSortDescriptor *)descriptor
                 error:(NSError **)error;
 
+/**
+ *  Fetch an object for this entity from the persistent store, using specific fetch options. The fetch limit of the options is ignored.
+ *
+ *  @param options The fetch options.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The fetched object or nil if none exists or an error occurs.
+ */
++(id)getWithOptions:(RHFetchOptions *)options
+              error:(NSError **)error;
+
+/**
+ *  Returns the object for this entity with a specific value for its uniqueKeyProperty. The keys and object IDs of all objects are loaded into an identity index the first time, after which lookups are done in memory and the object is returned as a fault if it is not registered in the managed object context yet. The index is kept up to date with every commit. While the managed object context of the current thread has unsaved changes for this entity the object is fetched instead, so those changes are taken into account.
+ *
+ *  @param key   The value of the unique key attribute.
+ *  @param error If an error occurs, upon return contains an NSError object that describes the problem. Fails with RHManagedObjectErrorNoUniqueKey if uniqueKeyProperty returns nil.
+ *
+ *  @return The object or nil if none exists or an error occurs.
+ *  @see uniqueKeyProperty
+ */
++(id)getWithKey:(id)key
+          error:(NSError **)error;
+
+/**
+ *  Returns the objects for this entity with specific values for their uniqueKeyProperty, resolved with the identity index like getWithKey:error:.
+ *
+ *  @param keys  The values of the unique key attribute.
+ *  @param error If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return A dictionary with the keys that were found as keys and the objects as values, or nil if an error occurs.
+ *  @see getWithKey:error:
+ */
++(NSDictionary *)objectsWithKeys:(NSArray *)keys
+                           error:(NSError **)error;
+
 
 
 #pragma mark - Fetching Objects as an Arrays
@@ -327,6 +459,62 @@ typedef void (^RHDidDeleteBlock)(void);
 			includeSubentities:(BOOL)includeSubentities
                          error:(NSError **)error;
 
+/**
+ *  Fetch objects for this entity from the persistent store, using specific fetch options. The fetched objects are returned as an array.
+ *
+ *  @param options The fetch options.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return An array containing the fetched objects.
+ */
++(NSArray *)fetchWithOptions:(RHFetchOptions *)options
+                       error:(NSError **)error;
+
+
+
+#pragma mark - Enumerating Large Numbers of Objects
+/**---------------------------------------------------------------------------------------
+ * @name Enumerating Large Numbers of Objects
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Enumerates the objects for this entity that match a specific predicate, fetching them in batches.
+ *
+ *  @param predicate   The predicate that should match with the objects. If nil all objects will be enumerated.
+ *  @param descriptors An array of sort descriptors that determines the order of enumeration. If nil the store's order is used.
+ *  @param batchSize   The number of objects to fetch per batch. If 0, a batch size of 500 is used.
+ *  @param block       The block that is executed for each object. Set stop to YES to stop the enumeration.
+ *  @param error       If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of objects the block was called with. If an error occurred this will return NSNotFound.
+ *  @see enumerateWithPredicate:sortDescriptors:batchSize:commitsChanges:usingBlock:error:
+ */
++(NSUInteger)enumerateWithPredicate:(NSPredicate *)predicate
+                    sortDescriptors:(NSArray *)descriptors
+                          batchSize:(NSUInteger)batchSize
+                         usingBlock:(void (^)(id object, BOOL *stop))block
+                              error:(NSError **)error;
+
+/**
+ *  Enumerates the objects for this entity that match a specific predicate, fetching them in batches. Unlike fetchWithPredicate:error:, memory usage stays flat regardless of the number of objects: the object IDs are fetched one page per batch (with fetchOffset and fetchLimit), and after each batch the enumerated objects without unsaved changes are turned back into faults so the managed object context of the current thread releases them. With commitsChanges, objects that the block deletes or changes such that they no longer match the predicate are accounted for when the next page is fetched; changes to the sort order of the remaining objects, or objects inserted by other threads during the enumeration, may cause objects to be skipped or enumerated twice. The managed object context is not reset, so objects fetched before the enumeration remain valid.
+ *
+ *  @param predicate      The predicate that should match with the objects. If nil all objects will be enumerated.
+ *  @param descriptors    An array of sort descriptors that determines the order of enumeration. If nil the store's order is used.
+ *  @param batchSize      The number of objects to fetch per batch. If 0, a batch size of 500 is used.
+ *  @param commitsChanges Whether or not changes are committed after each batch. Without committing, objects changed in the block remain in memory until the next commit.
+ *  @param block          The block that is executed for each object. Set stop to YES to stop the enumeration; the current batch is still committed.
+ *  @param error          If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The number of objects the block was called with. If an error occurred this will return NSNotFound; batches committed before the error remain committed.
+ */
++(NSUInteger)enumerateWithPredicate:(NSPredicate *)predicate
+                    sortDescriptors:(NSArray *)descriptors
+                          batchSize:(NSUInteger)batchSize
+                     commitsChanges:(BOOL)commitsChanges
+                         usingBlock:(void (^)(id object, BOOL *stop))block
+                              error:(NSError **)error;
+
 
 
 #pragma mark - Background Fetching Objects as an Array
@@ -348,6 +536,17 @@ typedef void (^RHDidDeleteBlock)(void);
                             withLimit:(NSUInteger)limit
                            completion:(void (^)(NSArray *fetchedObjects, NSError* error))completion;
 
+/**
+ *  Fetch objects for this entity from the persistent store in a background thread, using specific fetch options. The fetched objects are returned as an array in the completion handler.
+ *
+ *  Only the object IDs are fetched in the background. The objects are then loaded in the main thread managed object context with a single fetch, so the time spent on the main thread does not depend on the number of objects. Combine with fetchBatchSize to load the objects only as they are accessed.
+ *
+ *  @param options    The fetch options. These are copied before the fetch starts.
+ *  @param completion The comletion handler that will be executed after the fetch has completed.
+ */
++(void)fetchInBackgroundWithOptions:(RHFetchOptions *)options
+                         completion:(void (^)(NSArray *fetchedObjects, NSError* error))completion;
+
 
 
 #pragma mark - Fetching Objects as a Key-Value Dictionary
@@ -431,6 +630,19 @@ typedef void (^RHDidDeleteBlock)(void);
                               includeSubentities:(BOOL)includeSubentities
                                            error:(NSError **)error;
 
+/**
+ *  Fetch objects for this entity from the persistent store, using specific fetch options. The fetched objects are returned as a key-value dictionary with the value of the object's key property as key.
+ *
+ *  @param keyProperty The name of a property of the managed object. This value of this property is used as the key in the resulting dictionary. If the value is nil, the object is not included in the results.
+ *  @param options     The fetch options.
+ *  @param error       If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return A dictionary containing the fetched objects.
+ */
++(NSDictionary*)fetchAsDictionaryWithKeyProperty:(NSString *)keyProperty
+                                         options:(RHFetchOptions *)options
+                                           error:(NSError **)error;
+
 
 
 #pragma mark - Background Fetching Objects as a Key-Value Dictionary
@@ -454,6 +666,17 @@ typedef void (^RHDidDeleteBlock)(void);
                                           withLimit:(NSUInteger)limit
                                          completion:(void (^)(NSDictionary *fetchedObjects, NSError *error))completion;
 
+/**
+ *  Fetch objects for this entity from the persistent store in a background thread, using specific fetch options. The fetched objects are returned as a key-value dictionary with the value of the object's key property as key in the completion handler.
+ *
+ *  @param keyProperty The name of a property of the managed object. This value of this property is used as the key in the resulting dictionary. If the value is nil, the object is not included in the results.
+ *  @param options     The fetch options. These are copied before the fetch starts.
+ *  @param completion  The comletion handler that will be executed after the fetch has completed.
+ */
++(void)fetchInBackgroundAsDictionaryWithKeyProperty:(NSString *)keyProperty
+                                            options:(RHFetchOptions *)options
+                                         completion:(void (^)(NSDictionary *fetchedObjects, NSError *error))completion;
+
 
 
 #pragma mark - Counting Objects in the Persistent Store
@@ -506,6 +729,23 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 +(RHManagedObjectContextManager *)managedObjectContextManager;
 
+/**
+ *  Executes a block in the background with a managed object context from the pool of the managed object context manager. The RHManagedObject class methods called within the block use this managed object context. Changes are committed after the block returns.
+ *
+ *  @param block      The block to execute.
+ *  @param completion The completion handler that will be executed on the main thread after the changes are committed.
+ *  @see [RHManagedObjectContextManager performInBackground:completion:]
+ */
++(void)performInBackground:(void (^)(NSManagedObjectContext *moc))block
+                completion:(void (^)(NSError *error))completion;
+
+/**
+ *  Removes the cached managed object context manager and entity description of every RHManagedObject subclass that belongs to a specific managed object context manager. The cache is filled on first use of each subclass. This is called by deleteStore and does not need to be called directly.
+ *
+ *  @param manager The managed object context manager.
+ */
++(void)invalidateCachedMetadataForContextManager:(RHManagedObjectContextManager *)manager;
+
 /**
  *  Returns whether or not the data model of the stored database is compatible with the current data model.
  *
@@ -527,18 +767,48 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 
 /**
- *  Get all unique values for a specific attribute, for all objects for this entity in the persistent store that match a specific predicate.
+ *  Get all unique values for a specific attribute, for all objects for this entity in the persistent store that match a specific predicate. The values are computed and sorted in the persistent store without fetching the objects, so unsaved changes are not taken into account.
  *
  *  @param attribute The name of the attribute.
  *  @param predicate The predicate that should match with the objects.
  *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
  *
- *  @return An array containing all unique values for the attribute.
+ *  @return An array containing all unique values for the attribute in ascending order.
  */
 +(NSArray *)distinctValuesWithAttribute:(NSString *)attribute
                               predicate:(NSPredicate *)predicate
                                   error:(NSError **)error;
 
+/**
+ *  Get the unique values for a specific attribute, for all objects for this entity in the persistent store that match a specific predicate. The values are computed and sorted in the persistent store without fetching the objects, so unsaved changes are not taken into account.
+ *
+ *  @param attribute The name of the attribute.
+ *  @param predicate The predicate that should match with the objects.
+ *  @param limit     The maximum amount of values to return. If 0 all values will be returned.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return An array containing the unique values for the attribute in ascending order.
+ */
++(NSArray *)distinctValuesWithAttribute:(NSString *)attribute
+                              predicate:(NSPredicate *)predicate
+                                  limit:(NSUInteger)limit
+                                  error:(NSError **)error;
+
+/**
+ *  Get the unique values for a specific attribute together with the number of objects having that value, for all objects for this entity in the persistent store that match a specific predicate. The values are grouped, counted and sorted in the persistent store without fetching the objects, so unsaved changes are not taken into account.
+ *
+ *  @param attribute The name of the attribute.
+ *  @param predicate The predicate that should match with the objects.
+ *  @param limit     The maximum amount of values to return. If 0 all values will be returned.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return An array of dictionaries in ascending order of the value. Each dictionary contains the value with the name of the attribute as key, and the number of objects with RHDistinctValueCountKey as key.
+ */
++(NSArray *)distinctValuesAndCountsWithAttribute:(NSString *)attribute
+                                       predicate:(NSPredicate *)predicate
+                                           limit:(NSUInteger)limit
+                                           error:(NSError **)error;
+
 /**
  *  Returns the type of the attribute in the data model.
  *
@@ -553,7 +823,7 @@ typedef void (^RHDidDeleteBlock)(void);
 /**
  *  Compares all values for a specific attribute based on aggregate type, for all objects for this entity in the persistent store that match a specific predicate.
  *
- *  @param aggregate    The aggregate type. Based on this value the minimum, maximum, average or sum of all values is returned.
+ *  @param aggregate    The aggregate type. Based on this value the minimum, maximum, average, sum, count or number of distinct values is returned.
  *  @param key          The name of the attribute.
  *  @param predicate    The predicate that should match with the objects.
  *  @param defaultValue If this method would normally return nil, defaultValue will be returned instead.
@@ -567,6 +837,50 @@ typedef void (^RHDidDeleteBlock)(void);
           defaultValue:(id)defaultValue
                  error:(NSError **)error;
 
+/**
+ *  Computes several aggregates in a single fetch, for all objects for this entity in the persistent store that match a specific predicate, optionally grouped by one or more key paths. Aggregates of type RHAggregateCountDistinct are not supported by the persistent store and require one additional fetch each.
+ *
+ *  @param aggregates      An array of RHAggregateDescription instances.
+ *  @param groupByKeyPaths An array of key paths to group the objects by. If nil all objects form a single group.
+ *  @param havingPredicate A predicate to filter the groups. Aggregates are referenced by name as variables (e.g., "$sumSalary > 1000"). If nil all groups are returned.
+ *  @param predicate       The predicate that should match with the objects. If nil all objects will be aggregated.
+ *  @param error           If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return An array of dictionaries in ascending order of the group key paths, one per group. Each dictionary contains the values of the group key paths and the result of each aggregate with its name as key.
+ */
++(NSArray *)aggregatesWithDescriptions:(NSArray *)aggregates
+                               groupBy:(NSArray *)groupByKeyPaths
+                                having:(NSPredicate *)havingPredicate
+                             predicate:(NSPredicate *)predicate
+                                 error:(NSError **)error;
+
+/**
+ *  Returns a materialized count of the objects for this entity that match a specific predicate. The count is computed once and then kept up to date with every commit, so reading its value does not access the persistent store.
+ *
+ *  @param predicate The predicate that should match with the objects. If nil all objects will be counted.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The registered RHMaterializedAggregate instance.
+ *  @see materializedAggregateWithType:key:predicate:error:
+ */
++(RHMaterializedAggregate *)materializedCountWithPredicate:(NSPredicate *)predicate
+                                                     error:(NSError **)error;
+
+/**
+ *  Returns a materialized aggregate for all objects for this entity that match a specific predicate. The value is computed once and then kept up to date with every commit, so reading it does not access the persistent store. Asking twice for the same aggregate returns the same instance.
+ *
+ *  @param aggregate The aggregate type.
+ *  @param key       The name of the attribute. Only RHAggregateCount accepts nil, which counts the objects.
+ *  @param predicate The predicate that should match with the objects. If nil all objects will be aggregated.
+ *  @param error     If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The registered RHMaterializedAggregate instance.
+ */
++(RHMaterializedAggregate *)materializedAggregateWithType:(RHAggregate)aggregate
+                                                      key:(NSString *)key
+                                                predicate:(NSPredicate *)predicate
+                                                    error:(NSError **)error;
+
 
 
 #pragma mark - Transfering Managed Objects Between Threads
@@ -611,6 +925,60 @@ typedef void (^RHDidDeleteBlock)(void);
  */
 +(NSSet *)setInCurrentThreadContext:(NSSet*)set;
 
+/**
+ *  Takes an array containing Managed Objects and returns an array containing instances for the Managed Objects for the current thread, in the same order.
+ *
+ *  @param array An array containing Managed Objects. Any object that is not an RHManagedObject subclass is skipped.
+ *  @param mode  How the instances are obtained. RHContextTransferFaults is the cheapest if only a few of the objects will be accessed, RHContextTransferBatchFetch if most of them will. With RHContextTransferFaults, objects that were deleted in the meantime are not removed and raise an exception when accessed.
+ *
+ *  @return An array containing instances of the Managed Objects for the current thread.
+ */
++(NSArray*)arrayInCurrentThreadContext:(NSArray *)array mode:(RHContextTransferMode)mode;
+
+/**
+ *  Takes a dictionary containing Managed Objects and returns a dictionary with the same keys containing instances for the Managed Objects for the current thread.
+ *
+ *  @param dictionary A dictionary containing Managed Objects. Any object that is not an RHManagedObject subclass is skipped.
+ *  @param mode       How the instances are obtained.
+ *
+ *  @return A dictionary containing instances of the Managed Objects for the current thread.
+ *  @see arrayInCurrentThreadContext:mode:
+ */
++(NSDictionary *)dictionaryInCurrentThreadContext:(NSDictionary *)dictionary mode:(RHContextTransferMode)mode;
+
+/**
+ *  Takes a set containing Managed Objects and returns a set containing instances for the Managed Objects for the current thread.
+ *
+ *  @param set  A set containing Managed Objects. Any object that is not an RHManagedObject subclass is skipped.
+ *  @param mode How the instances are obtained.
+ *
+ *  @return A set containing instances of the Managed Objects for the current thread.
+ *  @see arrayInCurrentThreadContext:mode:
+ */
++(NSSet *)setInCurrentThreadContext:(NSSet*)set mode:(RHContextTransferMode)mode;
+
+/**
+ *  Takes an array of object IDs and returns an array containing the Managed Objects for the current thread, in the same order. Passing object IDs instead of Managed Objects means the objects never have to be accessed in the thread they came from.
+ *
+ *  @param objectIDs An array of NSManagedObjectID instances. The objects may be of different entities.
+ *  @param mode      How the instances are obtained. Objects that no longer exist are skipped, except with RHContextTransferFaults.
+ *
+ *  @return An array containing the Managed Objects for the current thread.
+ *  @see arrayInCurrentThreadContext:mode:
+ */
++(NSArray *)arrayWithObjectIDs:(NSArray *)objectIDs mode:(RHContextTransferMode)mode;
+
+/**
+ *  Takes a dictionary with object IDs as values and returns a dictionary with the same keys containing the Managed Objects for the current thread.
+ *
+ *  @param objectIDs A dictionary with NSManagedObjectID instances as values.
+ *  @param mode      How the instances are obtained. Objects that no longer exist are skipped, except with RHContextTransferFaults.
+ *
+ *  @return A dictionary containing the Managed Objects for the current thread.
+ *  @see arrayWithObjectIDs:mode:
+ */
++(NSDictionary *)dictionaryWithObjectIDs:(NSDictionary *)objectIDs mode:(RHContextTransferMode)mode;
+
 
 
 #pragma mark - Converting to Foundation Objects
@@ -623,11 +991,49 @@ typedef void (^RHDidDeleteBlock)(void);
  *  Converts the Managed Object to a key-value dictionary with the names of the attributes as key and the values of the attributes as value. Relationships are not included.
  *
  *  @return A dictionary containing the attributes of the Managed Object.
+ *  @see RHExporter
  */
 -(NSDictionary *)serialize;
 
 @end
 
+
+#pragma mark - RHAggregateDescription interface -
+/**
+ RHAggregateDescription describes a single aggregate (e.g., the sum of the salaries) for aggregatesWithDescriptions:groupBy:having:predicate:error:.
+ */
+@interface RHAggregateDescription : NSObject
+
+/**
+ *  Returns an aggregate description named after its type and key (e.g., "sumSalary" for RHAggregateSum on "salary").
+ *
+ *  @param aggregate The aggregate type.
+ *  @param key       The key path of the attribute.
+ *
+ *  @return An aggregate description.
+ */
++(RHAggregateDescription *)aggregateWithType:(RHAggregate)aggregate key:(NSString *)key;
+
+/**
+ *  Returns an aggregate description with a specific name.
+ *
+ *  @param aggregate The aggregate type.
+ *  @param key       The key path of the attribute.
+ *  @param name      The key of the result in the returned dictionaries.
+ *
+ *  @return An aggregate description.
+ */
++(RHAggregateDescription *)aggregateWithType:(RHAggregate)aggregate key:(NSString *)key name:(NSString *)name;
+
+@property (nonatomic, readonly) RHAggregate aggregate;
+@property (nonatomic, readonly) NSString *key;
+@property (nonatomic, readonly) NSString *name;
+
+@end
+
+
+#if TARGET_OS_IPHONE
 @interface ImageToDataTransformer : NSValueTransformer
 
 @end
+#endif
@@ -24,9 +24,62 @@
 
 #import "RHManagedObject.h"
 #import "RHManagedObjectContextManager.h"
+#import "RHMaterializedAggregate.h"
+
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#endif
+
+#define kImportBatchSize 500 // Default number of records per batch in importRecords:uniqueKey:batchSize:error:
+#define kEnumerateBatchSize 500 // Default number of objects per batch in enumerateWithPredicate:sortDescriptors:batchSize:commitsChanges:usingBlock:error:
+#define kMetadataSnapshotGracePeriod 10.0 // Seconds a replaced metadata snapshot is kept for readers that loaded it before it is released
+
+// Everything that is resolved for an RHManagedObject subclass on every call, looked up once per class.  The manager is owned
+// by sharedInstances, so retired snapshots don't keep a manager alive after deleteStore.
+@interface RHEntityMetadata : NSObject
+@property (nonatomic, weak) RHManagedObjectContextManager *manager;
+@property (nonatomic, strong) NSEntityDescription *entityDescription;
+@property (nonatomic, strong) NSDictionary *attributeTypes;
+@property (nonatomic, strong) NSArray *keyPaths;
+@end
+
+@implementation RHEntityMetadata
+@end
+
+@interface RHAggregateDescription()
+@property (nonatomic, readwrite) RHAggregate aggregate;
+@property (nonatomic, readwrite) NSString *key;
+@property (nonatomic, readwrite) NSString *name;
+// aggregateWithType:key:predicate:defaultValue:error: has always returned the type of the attribute, also for averages
+@property (nonatomic, assign) BOOL usesAttributeResultType;
+@end
+
+// An immutable Class -> RHEntityMetadata dictionary.  Readers load the pointer without taking a lock; writers copy it, add or
+// remove entries and publish the copy under RHMetadataLock.  A reader only uses a snapshot for the lookup of one entry, so a
+// replaced snapshot is retired and released by a later publish once kMetadataSnapshotGracePeriod has passed.  Snapshots are
+// only replaced while classes warm up and after deleteStore, so at most the snapshots of one grace period are retired.
+static CFDictionaryRef RHMetadataSnapshot = NULL;
+static NSMutableArray *RHRetiredMetadataSnapshots = nil; // Pairs of snapshot and retirement date, oldest first
+static NSObject *RHMetadataLock = nil;
 
 @interface RHManagedObject()
++(RHEntityMetadata *)metadata;
++(void)publishMetadataSnapshot:(NSDictionary *)metadataByClass;
 +(NSString *)aggregateToString:(RHAggregate)aggregate;
++(BOOL)importBatch:(NSArray *)batch uniqueKey:(NSString *)uniqueKey error:(NSError **)error;
++(NSArray *)objectIDsWithOptions:(RHFetchOptions *)options error:(NSError **)error;
++(NSArray *)objectsWithIDs:(NSArray *)objectIDs options:(RHFetchOptions *)options error:(NSError **)error;
++(NSDictionary *)dictionaryWithObjects:(NSArray *)objects keyProperty:(NSString *)keyProperty;
++(NSUInteger)enumerateBatch:(NSArray *)objectIDs commitsChanges:(BOOL)commitsChanges predicate:(NSPredicate *)predicate usingBlock:(void (^)(id object, BOOL *stop))block stop:(BOOL *)stop removed:(NSUInteger *)removed error:(NSError **)error;
++(NSManagedObjectContext *)managedObjectContextForObjectID:(NSManagedObjectID *)objectID;
++(NSDictionary *)objectsByIDWithObjectIDs:(id<NSFastEnumeration>)objectIDs mode:(RHContextTransferMode)mode;
++(NSAttributeType)attributeTypeWithKeyPath:(NSString *)keyPath entity:(NSEntityDescription *)entity;
++(NSExpressionDescription *)expressionDescriptionWithAggregate:(RHAggregateDescription *)aggregate entity:(NSEntityDescription *)entity;
++(NSArray *)groupWithRow:(NSDictionary *)row keyPaths:(NSArray *)keyPaths;
++(NSArray *)aggregateRowsWithDescriptions:(NSArray *)aggregates groupBy:(NSArray *)groupByKeyPaths having:(NSPredicate *)havingPredicate predicate:(NSPredicate *)predicate error:(NSError **)error;
++(NSFetchRequest *)distinctFetchRequestWithAttribute:(NSString *)attribute predicate:(NSPredicate *)predicate limit:(NSUInteger)limit error:(NSError **)error;
++(RHIdentityIndex *)identityIndexWithError:(NSError **)error;
++(BOOL)hasPendingChangesInContext:(NSManagedObjectContext *)moc;
 @end
 
 @implementation RHManagedObject
@@ -34,6 +87,106 @@
 @synthesize didUpdateBlock;
 @synthesize didDeleteBlock;
 
++(RHEntityMetadata *)metadata {
+	CFDictionaryRef snapshot = __atomic_load_n(&RHMetadataSnapshot, __ATOMIC_ACQUIRE);
+
+	if (snapshot) {
+		RHEntityMetadata *metadata = (__bridge RHEntityMetadata *)CFDictionaryGetValue(snapshot, (__bridge const void *)self);
+		if (metadata) {
+			return metadata;
+		}
+	}
+
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		RHMetadataLock = [[NSObject alloc] init];
+		RHRetiredMetadataSnapshots = [[NSMutableArray alloc] init];
+	});
+
+	// Resolved before taking the lock, since it may load the model and the first lookups of other classes would wait for it
+	RHEntityMetadata *metadata = [[RHEntityMetadata alloc] init];
+	metadata.manager = [RHManagedObjectContextManager sharedInstanceWithModelName:[self modelName] bundle:[NSBundle bundleForClass:[self class]]];
+	metadata.entityDescription = [metadata.manager entityForName:[self entityName]];
+
+	NSMutableDictionary *attributeTypes = [NSMutableDictionary dictionary];
+	for (NSAttributeDescription *attribute in [[metadata.entityDescription attributesByName] allValues]) {
+		[attributeTypes setObject:[NSNumber numberWithUnsignedInteger:[attribute attributeType]] forKey:[attribute name]];
+	}
+	metadata.attributeTypes = attributeTypes;
+	metadata.keyPaths = [[metadata.entityDescription propertiesByName] allKeys];
+
+	@synchronized(RHMetadataLock) {
+		snapshot = RHMetadataSnapshot;
+
+		// Another thread published the metadata of this class first
+		if (snapshot && CFDictionaryGetValue(snapshot, (__bridge const void *)self)) {
+			return (__bridge RHEntityMetadata *)CFDictionaryGetValue(snapshot, (__bridge const void *)self);
+		}
+
+		NSMutableDictionary *metadataByClass = [NSMutableDictionary dictionary];
+		if (snapshot) {
+			[metadataByClass addEntriesFromDictionary:(__bridge NSDictionary *)snapshot];
+		}
+		[metadataByClass setObject:metadata forKey:(id<NSCopying>)self];
+
+		[self publishMetadataSnapshot:metadataByClass];
+
+		return metadata;
+	}
+}
+
+// Must be called while holding RHMetadataLock
++(void)publishMetadataSnapshot:(NSDictionary *)metadataByClass {
+	// Pointer identity keys, so lookups never call -hash or -isEqual: on the class
+	CFMutableDictionaryRef snapshot = CFDictionaryCreateMutable(kCFAllocatorDefault, [metadataByClass count], NULL, &kCFTypeDictionaryValueCallBacks);
+
+	for (id cls in metadataByClass) {
+		CFDictionarySetValue(snapshot, (__bridge const void *)cls, (__bridge const void *)[metadataByClass objectForKey:cls]);
+	}
+
+	CFDictionaryRef previousSnapshot = RHMetadataSnapshot;
+	__atomic_store_n(&RHMetadataSnapshot, (CFDictionaryRef)snapshot, __ATOMIC_RELEASE);
+
+	NSDate *now = [NSDate date];
+
+	while ([RHRetiredMetadataSnapshots count] > 0) {
+		NSDate *retirementDate = [[RHRetiredMetadataSnapshots firstObject] lastObject];
+
+		if ([now timeIntervalSinceDate:retirementDate] < kMetadataSnapshotGracePeriod) {
+			break;
+		}
+
+		[RHRetiredMetadataSnapshots removeObjectAtIndex:0];
+	}
+
+	if (previousSnapshot) {
+		[RHRetiredMetadataSnapshots addObject:[NSArray arrayWithObjects:(__bridge_transfer id)previousSnapshot, now, nil]];
+	}
+}
+
++(void)invalidateCachedMetadataForContextManager:(RHManagedObjectContextManager *)manager {
+	if (RHMetadataLock == nil) {
+		return;
+	}
+
+	@synchronized(RHMetadataLock) {
+		CFDictionaryRef snapshot = RHMetadataSnapshot;
+
+		if (snapshot == NULL) {
+			return;
+		}
+
+		NSMutableDictionary *metadataByClass = [NSMutableDictionary dictionary];
+		[(__bridge NSDictionary *)snapshot enumerateKeysAndObjectsUsingBlock:^(id cls, RHEntityMetadata *metadata, BOOL *stop) {
+			if (metadata.manager != manager) {
+				[metadataByClass setObject:metadata forKey:cls];
+			}
+		}];
+
+		[self publishMetadataSnapshot:metadataByClass];
+	}
+}
+
 +(NSString *)entityName {
     return NSStringFromClass([self superclass]);
 }
@@ -50,8 +203,20 @@
 }
 
 +(NSEntityDescription *)entityDescriptionWithError:(NSError **)error {
-	return [NSEntityDescription entityForName:[self entityName]
-                       inManagedObjectContext:[self managedObjectContextForCurrentThreadWithError:error]];
+	NSEntityDescription *entityDescription = [[self metadata] entityDescription];
+
+	if (entityDescription) {
+		return entityDescription;
+	}
+
+	// The context is nil while the stores are loading or after they failed to load, which the lookup would raise on
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	if (moc == nil) {
+		return nil;
+	}
+
+	return [NSEntityDescription entityForName:[self entityName] inManagedObjectContext:moc];
 }
 
 +(NSError *)deleteStore {
@@ -70,9 +235,94 @@
     return nil;
 }
 
++(NSError *)commitImmediately {
+	return [[self managedObjectContextManager] commitImmediately];
+}
+
++(NSArray *)updateWithPredicate:(NSPredicate *)predicate
+             propertiesToUpdate:(NSDictionary *)propertiesToUpdate
+                          error:(NSError **)error {
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	NSError *storeError = nil;
+
+	if (![manager supportsBatchRequestsForEntity:[self entityDescriptionWithError:nil] error:&storeError]) {
+		// The stores could not be loaded, which is not a reason to fall back
+		if (storeError) {
+			if (error) {
+				*error = storeError;
+			}
+			return nil;
+		}
+
+		// Like the batch request, the fallback is committed right away, from a temporary context so the
+		// pending changes of the current thread's context are not committed along with it
+		__block NSArray *objectIDs = nil;
+		__block NSError *updateError = nil;
+
+		BOOL performed = [manager performWithTemporaryContext:^(NSManagedObjectContext *moc) {
+			NSArray *items = [self fetchWithPredicate:predicate error:&updateError];
+
+			if (items == nil) {
+				return;
+			}
+
+			NSMutableArray *updatedObjectIDs = [NSMutableArray arrayWithCapacity:[items count]];
+
+			for (RHManagedObject *item in items) {
+				for (NSString *key in propertiesToUpdate) {
+					id value = [propertiesToUpdate objectForKey:key];
+
+					if ([value isKindOfClass:[NSExpression class]]) {
+						value = [value expressionValueWithObject:item context:nil];
+					}
+
+					[item setValue:([value isKindOfClass:[NSNull class]] ? nil : value) forKey:key];
+				}
+				[updatedObjectIDs addObject:[item objectID]];
+			}
+
+			updateError = [self commitImmediately];
+
+			if (updateError == nil) {
+				objectIDs = [updatedObjectIDs copy];
+			}
+		} error:&updateError];
+
+		if (!performed || (objectIDs == nil)) {
+			if (error) {
+				*error = updateError;
+			}
+			return nil;
+		}
+
+		return objectIDs;
+	}
+
+	NSBatchUpdateRequest *request = [[NSBatchUpdateRequest alloc] initWithEntity:[self entityDescriptionWithError:error]];
+
+	if (predicate) {
+		[request setPredicate:predicate];
+	}
+
+	[request setPropertiesToUpdate:propertiesToUpdate];
+	[request setIncludesSubentities:[self shouldFetchRequestsReturnSubentities]];
+	[request setResultType:NSUpdatedObjectIDsResultType];
+
+	NSBatchUpdateResult *result = (NSBatchUpdateResult *)[manager executeBatchRequest:request error:error];
+
+	return [result result];
+}
+
 +(id)newEntityWithError:(NSError **)error {
-	return [NSEntityDescription insertNewObjectForEntityForName:[self entityName]
-                                         inManagedObjectContext:[self managedObjectContextForCurrentThreadWithError:error]];
+	// The context is nil while the stores are loading or after they failed to load, which the insert would raise on
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	if (moc == nil) {
+		return nil;
+	}
+
+	return [NSEntityDescription insertNewObjectForEntityForName:[self entityName] inManagedObjectContext:moc];
 }
 
 +(id)newOrExistingEntityWithPredicate:(NSPredicate *)predicate error:(NSError **)error {
@@ -80,23 +330,166 @@
     return existing ? existing : [self newEntityWithError:error];
 }
 
-+(id)getWithPredicate:(NSPredicate *)predicate
-                error:(NSError **)error {
++(NSUInteger)importRecords:(id<NSFastEnumeration>)records
+                 uniqueKey:(NSString *)uniqueKey
+                     error:(NSError **)error {
 
-	NSArray *results = [self fetchWithPredicate:predicate error:error];
+	return [self importRecords:records uniqueKey:uniqueKey batchSize:0 error:error];
+}
 
-	if ([results count] > 0) {
-		return [results objectAtIndex:0];
++(NSUInteger)importRecords:(id<NSFastEnumeration>)records
+                 uniqueKey:(NSString *)uniqueKey
+                 batchSize:(NSUInteger)batchSize
+                     error:(NSError **)error {
+
+	if (batchSize == 0) {
+		batchSize = kImportBatchSize;
 	}
 
-	return nil;
+	__block NSUInteger imported = 0;
+	__block NSError *importError = nil;
+
+	// Each batch is committed from a temporary context, so pending changes of the caller's context are not saved along with it
+	BOOL performed = [[self managedObjectContextManager] performWithTemporaryContext:^(NSManagedObjectContext *moc) {
+		NSMutableArray *batch = [NSMutableArray arrayWithCapacity:batchSize];
+
+		for (NSDictionary *record in records) {
+			[batch addObject:record];
+
+			if ([batch count] == batchSize) {
+				if (![self importBatch:batch uniqueKey:uniqueKey error:&importError]) {
+					return;
+				}
+
+				imported += [batch count];
+				[batch removeAllObjects];
+			}
+		}
+
+		if ([batch count] > 0) {
+			if (![self importBatch:batch uniqueKey:uniqueKey error:&importError]) {
+				return;
+			}
+
+			imported += [batch count];
+		}
+	} error:&importError];
+
+	if (!performed || importError) {
+		if (error) {
+			*error = importError;
+		}
+		return NSNotFound;
+	}
+
+	return imported;
+}
+
++(BOOL)importBatch:(NSArray *)batch uniqueKey:(NSString *)uniqueKey error:(NSError **)error {
+	NSError *batchError = nil;
+
+	@autoreleasepool {
+		NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:&batchError];
+		NSDictionary *attributes = [[self entityDescriptionWithError:&batchError] attributesByName];
+
+		NSMutableArray *keys = [NSMutableArray arrayWithCapacity:[batch count]];
+		for (NSDictionary *record in batch) {
+			id key = [record objectForKey:uniqueKey];
+			if (key && ![key isKindOfClass:[NSNull class]]) {
+				[keys addObject:key];
+			}
+		}
+
+		// One fetch for the whole batch instead of one getWithPredicate:error: per record
+		NSMutableDictionary *existing = [NSMutableDictionary dictionary];
+		if ([keys count] > 0) {
+			NSPredicate *predicate = [NSPredicate predicateWithFormat:@"%K IN %@", uniqueKey, keys];
+			[existing addEntriesFromDictionary:[self fetchAsDictionaryWithKeyProperty:uniqueKey
+																		withPredicate:predicate
+																				error:&batchError]];
+		}
+
+		NSMutableArray *imported = [NSMutableArray arrayWithCapacity:[batch count]];
+
+		for (NSDictionary *record in batch) {
+			id key = [record objectForKey:uniqueKey];
+			RHManagedObject *object = (key && ![key isKindOfClass:[NSNull class]]) ? [existing objectForKey:key] : nil;
+
+			if (object == nil) {
+				object = [self newEntityWithError:&batchError];
+
+				// Duplicates within the same batch update the object inserted before
+				if (key && ![key isKindOfClass:[NSNull class]]) {
+					[existing setObject:object forKey:key];
+				}
+			}
+
+			for (NSString *name in record) {
+				if ([attributes objectForKey:name] == nil) {
+					continue;
+				}
+
+				id value = [record objectForKey:name];
+				if ([value isKindOfClass:[NSNull class]]) {
+					value = nil;
+				}
+
+				// Avoid marking unchanged objects as updated
+				id currentValue = [object valueForKey:name];
+				if ((value != currentValue) && ![value isEqual:currentValue]) {
+					[object setValue:value forKey:name];
+				}
+			}
+
+			[imported addObject:object];
+		}
+
+		if (batchError == nil) {
+			batchError = [self commitImmediately];
+		}
+
+		if (batchError == nil) {
+			for (RHManagedObject *object in imported) {
+				[moc refreshObject:object mergeChanges:NO];
+			}
+		}
+	}
+
+	if (batchError) {
+		if (error) {
+			*error = batchError;
+		}
+		return NO;
+	}
+
+	return YES;
+}
+
++(id)getWithPredicate:(NSPredicate *)predicate
+                error:(NSError **)error {
+
+	return [self getWithPredicate:predicate sortDescriptor:nil error:error];
 }
 
 +(id)getWithPredicate:(NSPredicate *)predicate
        sortDescriptor:(NSSortDescriptor *)descriptor
                 error:(NSError **)error {
-	
-	NSArray *results = [self fetchWithPredicate:predicate sortDescriptor:descriptor error:error];
+
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.sortDescriptors = descriptor ? [NSArray arrayWithObject:descriptor] : nil;
+
+	return [self getWithOptions:options error:error];
+}
+
++(id)getWithOptions:(RHFetchOptions *)options
+              error:(NSError **)error {
+
+	RHFetchOptions *singleObjectOptions = [options copy];
+	singleObjectOptions.fetchLimit = 1;
+	singleObjectOptions.fetchBatchSize = 0;
+
+	NSArray *results = [self fetchWithOptions:singleObjectOptions error:error];
 
 	if ([results count] > 0) {
 		return [results objectAtIndex:0];
@@ -105,6 +498,98 @@
 	return nil;
 }
 
++(NSString *)uniqueKeyProperty {
+	return nil;
+}
+
++(RHIdentityIndex *)identityIndexWithError:(NSError **)error {
+	NSString *keyProperty = [self uniqueKeyProperty];
+
+	if (keyProperty == nil) {
+		if (error) {
+			*error = [NSError errorWithDomain:RHManagedObjectErrorDomain
+										 code:RHManagedObjectErrorNoUniqueKey
+									 userInfo:[NSDictionary dictionaryWithObject:[NSString stringWithFormat:@"%@ has no uniqueKeyProperty.", NSStringFromClass(self)] forKey:NSLocalizedDescriptionKey]];
+		}
+		return nil;
+	}
+
+	RHEntityMetadata *metadata = [self metadata];
+	return [metadata.manager identityIndexForEntity:metadata.entityDescription key:keyProperty];
+}
+
+// The identity index only knows about saved objects
++(BOOL)hasPendingChangesInContext:(NSManagedObjectContext *)moc {
+	if (![moc hasChanges]) {
+		return NO;
+	}
+
+	NSEntityDescription *entity = [[self metadata] entityDescription];
+
+	for (NSSet *objects in [NSArray arrayWithObjects:[moc insertedObjects], [moc updatedObjects], [moc deletedObjects], nil]) {
+		for (NSManagedObject *object in objects) {
+			if ([[object entity] isKindOfEntity:entity]) {
+				return YES;
+			}
+		}
+	}
+
+	return NO;
+}
+
++(id)getWithKey:(id)key
+          error:(NSError **)error {
+
+	RHIdentityIndex *index = [self identityIndexWithError:error];
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	if ((index == nil) || (moc == nil) || (key == nil)) {
+		return nil;
+	}
+
+	if ([self hasPendingChangesInContext:moc]) {
+		return [self getWithPredicate:[NSPredicate predicateWithFormat:@"%K == %@", index.key, key] error:error];
+	}
+
+	if (![index loadWithContext:moc error:error]) {
+		return nil;
+	}
+
+	NSManagedObjectID *objectID = [index objectIDForKey:key];
+
+	return objectID ? [moc objectWithID:objectID] : nil;
+}
+
++(NSDictionary *)objectsWithKeys:(NSArray *)keys
+                           error:(NSError **)error {
+
+	RHIdentityIndex *index = [self identityIndexWithError:error];
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	if ((index == nil) || (moc == nil)) {
+		return nil;
+	}
+
+	if ([self hasPendingChangesInContext:moc]) {
+		return [self fetchAsDictionaryWithKeyProperty:index.key
+										withPredicate:[NSPredicate predicateWithFormat:@"%K IN %@", index.key, keys]
+												error:error];
+	}
+
+	if (![index loadWithContext:moc error:error]) {
+		return nil;
+	}
+
+	NSDictionary *objectIDs = [index objectIDsForKeys:keys];
+	NSMutableDictionary *objects = [NSMutableDictionary dictionaryWithCapacity:[objectIDs count]];
+
+	for (id key in objectIDs) {
+		[objects setObject:[moc objectWithID:[objectIDs objectForKey:key]] forKey:key];
+	}
+
+	return objects;
+}
+
 +(NSArray *)fetchAllWithError:(NSError **)error {
 	return [self fetchWithPredicate:nil error:error];
 }
@@ -159,28 +644,214 @@
 			includeSubentities:(BOOL)includeSubentities
                          error:(NSError **)error {
 
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.sortDescriptors = descriptors;
+	options.fetchLimit = limit;
+	options.includesSubentities = includeSubentities;
+
+	return [self fetchWithOptions:options error:error];
+}
+
++(NSArray *)fetchWithOptions:(RHFetchOptions *)options
+                       error:(NSError **)error {
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	CFAbsoluteTime startTime = manager.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
 	NSFetchRequest *fetch = [NSFetchRequest new];
 
 	[fetch setEntity:[self entityDescriptionWithError:error]];
+	[options applyToFetchRequest:fetch];
 
-	if (predicate) {
-		[fetch setPredicate:predicate];
+	// system defaults to YES already
+	// [fetch setIncludesPendingChanges:YES];
+
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+	NSArray *objects = nil;
+
+	// Unsaved changes are included in the results, so they can not be cached
+	NSSet *entityNames = nil;
+	NSString *cacheKey = (manager.cachesQueries && moc && ![moc hasChanges]) ? [RHQueryCache keyForFetchRequest:fetch resultType:@"fetch" entityNames:&entityNames] : nil;
+	NSUInteger cacheGeneration = manager.queryCache.generation;
+	NSArray *cachedObjectIDs = cacheKey ? [manager.queryCache objectForKey:cacheKey] : nil;
+
+	if (cachedObjectIDs) {
+		NSMutableArray *cachedObjects = [NSMutableArray arrayWithCapacity:[cachedObjectIDs count]];
+
+		for (NSManagedObjectID *objectID in cachedObjectIDs) {
+			[cachedObjects addObject:[moc objectWithID:objectID]];
+		}
+
+		objects = cachedObjects;
+
+	} else {
+		objects = [moc executeFetchRequest:fetch error:error];
+
+		if (cacheKey && objects) {
+			[manager.queryCache setObject:[objects valueForKey:@"objectID"] forKey:cacheKey entityNames:entityNames generation:cacheGeneration];
+		}
 	}
 
-	if (descriptors) {
-		[fetch setSortDescriptors:descriptors];
+	if (manager.instrumented) {
+		[manager recordOperation:RHInstrumentationOperationFetch entityName:[[fetch entity] name] predicate:[fetch predicate] resultCount:[objects count] startTime:startTime context:moc];
 	}
 
-	if (limit > 0) {
-		[fetch setFetchLimit:limit];
+	return objects;
+}
+
++(NSUInteger)enumerateWithPredicate:(NSPredicate *)predicate
+                    sortDescriptors:(NSArray *)descriptors
+                          batchSize:(NSUInteger)batchSize
+                         usingBlock:(void (^)(id object, BOOL *stop))block
+                              error:(NSError **)error {
+
+	return [self enumerateWithPredicate:predicate sortDescriptors:descriptors batchSize:batchSize commitsChanges:NO usingBlock:block error:error];
+}
+
++(NSUInteger)enumerateWithPredicate:(NSPredicate *)predicate
+                    sortDescriptors:(NSArray *)descriptors
+                          batchSize:(NSUInteger)batchSize
+                     commitsChanges:(BOOL)commitsChanges
+                         usingBlock:(void (^)(id object, BOOL *stop))block
+                              error:(NSError **)error {
+
+	if (batchSize == 0) {
+		batchSize = kEnumerateBatchSize;
 	}
 
-	[fetch setIncludesSubentities:includeSubentities];
+	NSUInteger enumerated = 0;
+	NSUInteger offset = 0;
+	BOOL stop = NO;
 
-	// system defaults to YES already
-	// [fetch setIncludesPendingChanges:YES];
+	// One page of object IDs is fetched per batch, so memory usage does not depend on the number of objects
+	while (!stop) {
+		NSError *fetchError = nil;
+		NSArray *batch = nil;
 
-	return [[self managedObjectContextForCurrentThreadWithError:error] executeFetchRequest:fetch error:error];
+		@autoreleasepool {
+			NSFetchRequest *fetch = [NSFetchRequest new];
+			RHFetchOptions *options = [self fetchOptions];
+			options.predicate = predicate;
+			options.sortDescriptors = descriptors;
+
+			[fetch setEntity:[self entityDescriptionWithError:&fetchError]];
+			[options applyToFetchRequest:fetch];
+			[fetch setResultType:NSManagedObjectIDResultType];
+			[fetch setFetchOffset:offset];
+			[fetch setFetchLimit:batchSize];
+
+			// Unsaved changes would shift the pages; only the committed changes of a batch are accounted for below
+			[fetch setIncludesPendingChanges:NO];
+
+			batch = [[self managedObjectContextForCurrentThreadWithError:&fetchError] executeFetchRequest:fetch error:&fetchError];
+		}
+
+		if (batch == nil) {
+			if (error) {
+				*error = fetchError;
+			}
+			return NSNotFound;
+		}
+
+		if ([batch count] == 0) {
+			break;
+		}
+
+		NSUInteger removed = 0;
+		NSUInteger batchEnumerated = [self enumerateBatch:batch commitsChanges:commitsChanges predicate:predicate usingBlock:block stop:&stop removed:&removed error:error];
+
+		if (batchEnumerated == NSNotFound) {
+			return NSNotFound;
+		}
+
+		enumerated += batchEnumerated;
+
+		if ([batch count] < batchSize) {
+			break;
+		}
+
+		// Objects of this batch that are no longer in the store's results do not take up a place in the next page
+		offset += [batch count] - removed;
+	}
+
+	return enumerated;
+}
+
++(NSUInteger)enumerateBatch:(NSArray *)objectIDs commitsChanges:(BOOL)commitsChanges predicate:(NSPredicate *)predicate usingBlock:(void (^)(id object, BOOL *stop))block stop:(BOOL *)stop removed:(NSUInteger *)removed error:(NSError **)error {
+	NSError *batchError = nil;
+	NSUInteger enumerated = 0;
+
+	@autoreleasepool {
+		NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:&batchError];
+
+		NSFetchRequest *fetch = [NSFetchRequest new];
+		[fetch setEntity:[self entityDescriptionWithError:&batchError]];
+		[fetch setPredicate:[NSPredicate predicateWithFormat:@"self IN %@", objectIDs]];
+		[fetch setIncludesSubentities:YES];
+		[fetch setReturnsObjectsAsFaults:NO];
+
+		NSArray *fetchedObjects = [moc executeFetchRequest:fetch error:&batchError];
+
+		// The IN fetch does not preserve the order of the object IDs
+		NSMutableDictionary *objectsByID = [NSMutableDictionary dictionaryWithCapacity:[fetchedObjects count]];
+		for (NSManagedObject *object in fetchedObjects) {
+			[objectsByID setObject:object forKey:[object objectID]];
+		}
+
+		NSUInteger removedCount = 0;
+
+		for (NSManagedObjectID *objectID in objectIDs) {
+			// Objects deleted since the object IDs were fetched are skipped
+			id object = [objectsByID objectForKey:objectID];
+
+			if (object) {
+				block(object, stop);
+				enumerated++;
+			} else if (![[moc objectRegisteredForID:objectID] isDeleted]) {
+				removedCount++;
+			}
+
+			if (*stop) {
+				break;
+			}
+		}
+
+		// Committed deletions and updates that no longer match the predicate leave the store's results
+		if (commitsChanges) {
+			for (NSManagedObject *object in fetchedObjects) {
+				if ([object isDeleted] || (predicate && ![predicate evaluateWithObject:object])) {
+					removedCount++;
+				}
+			}
+		}
+
+		if (removed) {
+			*removed = removedCount;
+		}
+
+		if (commitsChanges && (batchError == nil)) {
+			batchError = [self commitImmediately];
+		}
+
+		// The context doesn't retain unchanged objects, so once they are faults they are freed with this pool
+		if (batchError == nil) {
+			for (NSManagedObject *object in fetchedObjects) {
+				if (![object hasChanges] && ![object isDeleted]) {
+					[moc refreshObject:object mergeChanges:NO];
+				}
+			}
+		}
+	}
+
+	if (batchError) {
+		if (error) {
+			*error = batchError;
+		}
+		return NSNotFound;
+	}
+
+	return enumerated;
 }
 
 // This can be overridden per subclass
@@ -188,34 +859,99 @@
     return YES;
 }
 
++(RHFetchOptions *)fetchOptions {
+	RHFetchOptions *options = [[RHFetchOptions alloc] init];
+	options.includesSubentities = [self shouldFetchRequestsReturnSubentities];
+	return options;
+}
+
 +(void)fetchInBackgroundWithPredicate:(NSPredicate *)predicate
                       sortDescriptors:(NSArray *)descriptors
                             withLimit:(NSUInteger)limit
                            completion:(void (^)(NSArray* fetchedObjects, NSError* error))completion {
 
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.sortDescriptors = descriptors;
+	options.fetchLimit = limit;
+
+	[self fetchInBackgroundWithOptions:options completion:completion];
+}
+
++(void)fetchInBackgroundWithOptions:(RHFetchOptions *)options
+                         completion:(void (^)(NSArray* fetchedObjects, NSError* error))completion {
+
+	options = [options copy];
+
+	// Only the object IDs are fetched in the background.  The main thread then loads all objects with a single fetch instead
+	// of one existingObjectWithID:error: per object.
     if ([NSThread isMainThread]) {
 		dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
 
             NSError* error = nil;
-            NSArray* fetchedObjects = [self fetchWithPredicate:predicate sortDescriptors:descriptors withLimit:limit error:&error];
+            NSArray* objectIDs = [self objectIDsWithOptions:options error:&error];
 
             dispatch_async(dispatch_get_main_queue(), ^{
-
-                NSArray* convertedFetchedObjects = [self arrayInCurrentThreadContext:fetchedObjects];
-                completion(convertedFetchedObjects, error);
+                NSError* mainError = error;
+                NSArray* fetchedObjects = [self objectsWithIDs:objectIDs options:options error:&mainError];
+                completion(fetchedObjects, mainError);
             });
         });
 	} else {
         NSError* error = nil;
-        NSArray* fetchedObjects = [self fetchWithPredicate:predicate sortDescriptors:descriptors withLimit:limit error:&error];
+        NSArray* objectIDs = [self objectIDsWithOptions:options error:&error];
 
         dispatch_async(dispatch_get_main_queue(), ^{
-            NSArray* convertedFetchedObjects = [self arrayInCurrentThreadContext:fetchedObjects];
-            completion(convertedFetchedObjects, error);
+            NSError* mainError = error;
+            NSArray* fetchedObjects = [self objectsWithIDs:objectIDs options:options error:&mainError];
+            completion(fetchedObjects, mainError);
         });
     }
 }
 
++(NSArray *)objectIDsWithOptions:(RHFetchOptions *)options error:(NSError **)error {
+	NSFetchRequest *fetch = [NSFetchRequest new];
+
+	[fetch setEntity:[self entityDescriptionWithError:error]];
+	[options applyToFetchRequest:fetch];
+
+	// These only apply to the objects loaded from the object IDs
+	[fetch setFetchBatchSize:0];
+	[fetch setPropertiesToFetch:nil];
+	[fetch setRelationshipKeyPathsForPrefetching:nil];
+	[fetch setResultType:NSManagedObjectIDResultType];
+
+	return [[self managedObjectContextForCurrentThreadWithError:error] executeFetchRequest:fetch error:error];
+}
+
+// Loads the objects for a list of object IDs in the current thread's context with one fetch.  The predicate, limit and offset
+// were already applied when the object IDs were fetched; the sort descriptors are applied again to restore the order.
++(NSArray *)objectsWithIDs:(NSArray *)objectIDs options:(RHFetchOptions *)options error:(NSError **)error {
+	if ([objectIDs count] == 0) {
+		return objectIDs;
+	}
+
+	RHFetchOptions *objectOptions = [options copy];
+	objectOptions.predicate = [NSPredicate predicateWithFormat:@"self IN %@", objectIDs];
+	objectOptions.fetchLimit = 0;
+	objectOptions.fetchOffset = 0;
+	objectOptions.includesSubentities = YES;
+
+	return [self fetchWithOptions:objectOptions error:error];
+}
+
++(NSDictionary *)dictionaryWithObjects:(NSArray *)objects keyProperty:(NSString *)keyProperty {
+    NSMutableDictionary* dictionary = [NSMutableDictionary new];
+
+    for (RHManagedObject* managedObject in objects) {
+        if ([managedObject valueForKey:keyProperty]) {
+            [dictionary setObject:managedObject forKey:[managedObject valueForKey:keyProperty]];
+        }
+    }
+
+    return [dictionary copy];
+}
+
 +(NSDictionary*)fetchAllAsDictionaryWithKeyProperty:(NSString*)keyProperty
                                               error:(NSError **)error {
 
@@ -257,18 +993,23 @@
                                        withLimit:(NSUInteger)limit
                               includeSubentities:(BOOL)includeSubentities
                                            error:(NSError **)error {
-    
-    NSArray *fetchedObjects = [self fetchWithPredicate:predicate sortDescriptors:descriptors withLimit:limit includeSubentities:includeSubentities error:error];
-    
-    NSMutableDictionary* dictionary = [NSMutableDictionary new];
-    
-    for (RHManagedObject* managedObject in fetchedObjects) {
-        if ([managedObject valueForKey:keyProperty]) {
-            [dictionary setObject:managedObject forKey:[managedObject valueForKey:keyProperty]];
-        }
-    }
-    
-    return [dictionary copy];
+
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.sortDescriptors = descriptors;
+	options.fetchLimit = limit;
+	options.includesSubentities = includeSubentities;
+
+	return [self fetchAsDictionaryWithKeyProperty:keyProperty options:options error:error];
+}
+
++(NSDictionary*)fetchAsDictionaryWithKeyProperty:(NSString *)keyProperty
+                                         options:(RHFetchOptions *)options
+                                           error:(NSError **)error {
+
+    NSArray *fetchedObjects = [self fetchWithOptions:options error:error];
+
+    return [self dictionaryWithObjects:fetchedObjects keyProperty:keyProperty];
 }
 
 +(void)fetchInBackgroundAsDictionaryWithKeyProperty:(NSString*)keyProperty
@@ -277,52 +1018,176 @@
                                           withLimit:(NSUInteger)limit
                                          completion:(void (^)(NSDictionary* fetchedObjects, NSError* error))completion {
 
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.sortDescriptors = descriptors;
+	options.fetchLimit = limit;
+
+	[self fetchInBackgroundAsDictionaryWithKeyProperty:keyProperty options:options completion:completion];
+}
+
++(void)fetchInBackgroundAsDictionaryWithKeyProperty:(NSString*)keyProperty
+                                            options:(RHFetchOptions *)options
+                                         completion:(void (^)(NSDictionary* fetchedObjects, NSError* error))completion {
+
+	options = [options copy];
+
+	// All objects are keyed, so they are loaded with their property values in the main thread fetch
+	options.returnsObjectsAsFaults = NO;
+	options.fetchBatchSize = 0;
+
     if ([NSThread isMainThread]) {
 		dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
 
-            NSError* error = nil;
-            NSDictionary* fetchedObjects = [self fetchAsDictionaryWithKeyProperty:keyProperty withPredicate:predicate withSortDescriptors:descriptors withLimit:limit error:&error];
+            NSError* error = nil;
+            NSArray* objectIDs = [self objectIDsWithOptions:options error:&error];
+
+            dispatch_async(dispatch_get_main_queue(), ^{
+                NSError* mainError = error;
+                NSArray* objects = [self objectsWithIDs:objectIDs options:options error:&mainError];
+                completion([self dictionaryWithObjects:objects keyProperty:keyProperty], mainError);
+            });
+        });
+	} else {
+        NSError* error = nil;
+        NSArray* objectIDs = [self objectIDsWithOptions:options error:&error];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            NSError* mainError = error;
+            NSArray* objects = [self objectsWithIDs:objectIDs options:options error:&mainError];
+            completion([self dictionaryWithObjects:objects keyProperty:keyProperty], mainError);
+        });
+    }
+}
+
+
+
++(NSUInteger)countWithError:(NSError **)error {
+	return [self countWithPredicate:nil error:error];
+}
+
++(NSUInteger)countWithPredicate:(NSPredicate *)predicate error:(NSError **)error {
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	CFAbsoluteTime startTime = manager.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+	NSFetchRequest *fetch = [[NSFetchRequest alloc] init];
+
+	[fetch setEntity:[self entityDescriptionWithError:error]];
+
+	if (predicate) {
+		[fetch setPredicate:predicate];
+	}
+
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+	NSUInteger count = NSNotFound;
+
+	NSSet *entityNames = nil;
+	NSString *cacheKey = (manager.cachesQueries && moc && ![moc hasChanges]) ? [RHQueryCache keyForFetchRequest:fetch resultType:@"count" entityNames:&entityNames] : nil;
+	NSUInteger cacheGeneration = manager.queryCache.generation;
+	NSNumber *cachedCount = cacheKey ? [manager.queryCache objectForKey:cacheKey] : nil;
+
+	if (cachedCount) {
+		count = [cachedCount unsignedIntegerValue];
+
+	} else {
+		count = [moc countForFetchRequest:fetch error:error];
+
+		if (cacheKey && (count != NSNotFound)) {
+			[manager.queryCache setObject:[NSNumber numberWithUnsignedInteger:count] forKey:cacheKey entityNames:entityNames generation:cacheGeneration];
+		}
+	}
+
+	if (manager.instrumented && (count != NSNotFound)) {
+		[manager recordOperation:RHInstrumentationOperationCount entityName:[[fetch entity] name] predicate:predicate resultCount:count startTime:startTime context:moc];
+	}
+
+	return count;
+}
+
++(NSArray *)distinctValuesWithAttribute:(NSString *)attribute
+                              predicate:(NSPredicate *)predicate
+                                  error:(NSError **)error {
+	return [self distinctValuesWithAttribute:attribute predicate:predicate limit:0 error:error];
+}
+
++(NSArray *)distinctValuesWithAttribute:(NSString *)attribute
+                              predicate:(NSPredicate *)predicate
+                                  limit:(NSUInteger)limit
+                                  error:(NSError **)error {
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	CFAbsoluteTime startTime = manager.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+	NSFetchRequest *fetch = [self distinctFetchRequestWithAttribute:attribute predicate:predicate limit:limit error:error];
+	[fetch setPropertiesToFetch:[NSArray arrayWithObject:attribute]];
+	[fetch setReturnsDistinctResults:YES];
+
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+	NSArray *rows = [moc executeFetchRequest:fetch error:error];
+
+	if (manager.instrumented && rows) {
+		[manager recordOperation:RHInstrumentationOperationAggregate entityName:[[fetch entity] name] predicate:predicate resultCount:[rows count] startTime:startTime context:moc];
+	}
 
-            dispatch_async(dispatch_get_main_queue(), ^{
-                NSDictionary* convertedFetchedObjects = [self dictionaryInCurrentThreadContext:fetchedObjects];
-                completion(convertedFetchedObjects, error);
-            });
-        });
-	} else {
-        NSError* error = nil;
-        NSDictionary* fetchedObjects = [self fetchAsDictionaryWithKeyProperty:keyProperty withPredicate:predicate withSortDescriptors:descriptors withLimit:limit error:&error];
+	if (rows == nil) {
+		return nil;
+	}
 
-        dispatch_async(dispatch_get_main_queue(), ^{
-            NSDictionary* convertedFetchedObjects = [self dictionaryInCurrentThreadContext:fetchedObjects];
-            completion(convertedFetchedObjects, error);
-        });
-    }
+	return [rows valueForKey:attribute];
 }
 
++(NSArray *)distinctValuesAndCountsWithAttribute:(NSString *)attribute
+                                       predicate:(NSPredicate *)predicate
+                                           limit:(NSUInteger)limit
+                                           error:(NSError **)error {
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	CFAbsoluteTime startTime = manager.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
 
+	NSExpression *expression = [NSExpression expressionForFunction:@"count:"
+														 arguments:[NSArray arrayWithObject:[NSExpression expressionForKeyPath:attribute]]];
 
-+(NSUInteger)countWithError:(NSError **)error {
-	return [self countWithPredicate:nil error:error];
+	NSExpressionDescription *expressionDescription = [[NSExpressionDescription alloc] init];
+	[expressionDescription setName:RHDistinctValueCountKey];
+	[expressionDescription setExpression:expression];
+	[expressionDescription setExpressionResultType:NSInteger64AttributeType];
+
+	NSFetchRequest *fetch = [self distinctFetchRequestWithAttribute:attribute predicate:predicate limit:limit error:error];
+	[fetch setPropertiesToFetch:[NSArray arrayWithObjects:attribute, expressionDescription, nil]];
+	[fetch setPropertiesToGroupBy:[NSArray arrayWithObject:attribute]];
+
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+	NSArray *rows = [moc executeFetchRequest:fetch error:error];
+
+	if (manager.instrumented && rows) {
+		[manager recordOperation:RHInstrumentationOperationAggregate entityName:[[fetch entity] name] predicate:predicate resultCount:[rows count] startTime:startTime context:moc];
+	}
+
+	return rows;
 }
 
-+(NSUInteger)countWithPredicate:(NSPredicate *)predicate error:(NSError **)error {
++(NSFetchRequest *)distinctFetchRequestWithAttribute:(NSString *)attribute
+                                           predicate:(NSPredicate *)predicate
+                                               limit:(NSUInteger)limit
+                                               error:(NSError **)error {
+
 	NSFetchRequest *fetch = [[NSFetchRequest alloc] init];
 
 	[fetch setEntity:[self entityDescriptionWithError:error]];
 
-	if (predicate) {
-		[fetch setPredicate:predicate];
+	// nil is excluded by the store rather than afterwards, so the fetch limit only counts values that are returned
+	NSPredicate *notNilPredicate = [NSPredicate predicateWithFormat:@"%K != nil", attribute];
+	[fetch setPredicate:predicate ? [NSCompoundPredicate andPredicateWithSubpredicates:[NSArray arrayWithObjects:predicate, notNilPredicate, nil]] : notNilPredicate];
+
+	if (limit > 0) {
+		[fetch setFetchLimit:limit];
 	}
 
-	return [[self managedObjectContextForCurrentThreadWithError:error] countForFetchRequest:fetch error:error];
-}
+	[fetch setIncludesSubentities:[self shouldFetchRequestsReturnSubentities]];
+	[fetch setResultType:NSDictionaryResultType];
+	[fetch setSortDescriptors:[NSArray arrayWithObject:[NSSortDescriptor sortDescriptorWithKey:attribute ascending:YES]]];
 
-+(NSArray *)distinctValuesWithAttribute:(NSString *)attribute
-                              predicate:(NSPredicate *)predicate
-                                  error:(NSError **)error {
-	NSArray *items = [self fetchWithPredicate:predicate error:error];
-	NSString *keyPath = [@"@distinctUnionOfObjects." stringByAppendingString:attribute];
-	return [[items valueForKeyPath:keyPath] sortedArrayUsingSelector:@selector(compare:)];
+	return fetch;
 }
 
 +(NSString*)aggregateToString:(RHAggregate)aggregate {
@@ -335,54 +1200,78 @@
             return @"average:";
 		case RHAggregateSum:
 			return @"sum:";
+		case RHAggregateCount:
+			return @"count:";
         default:
             [NSException raise:NSGenericException format:@"Unexpected FormatType."];
     }
+	return nil;
 }
 
 +(NSAttributeType)attributeTypeWithKey:(NSString *)key error:(NSError **)error {
-	NSEntityDescription *entityDescription = [self entityDescriptionWithError:error];
-	NSDictionary *properties = [entityDescription propertiesByName];
-	NSAttributeDescription *attribute = [properties objectForKey:key];
-	return [attribute attributeType];
+	return [[[[self metadata] attributeTypes] objectForKey:key] unsignedIntegerValue];
 }
 
-+(id)aggregateWithType:(RHAggregate)aggregate
-                   key:(NSString *)key
-             predicate:(NSPredicate *)predicate
-          defaultValue:(id)defaultValue
-                 error:(NSError **)error {
-	NSFetchRequest *fetch = [[NSFetchRequest alloc] init];
+// Follows the relationships of a key path (e.g., "department.budget") to its attribute
++(NSAttributeType)attributeTypeWithKeyPath:(NSString *)keyPath entity:(NSEntityDescription *)entity {
+	NSNumber *attributeType = [[[self metadata] attributeTypes] objectForKey:keyPath];
 
-	if (predicate) {
-		[fetch setPredicate:predicate];
+	if (attributeType) {
+		return [attributeType unsignedIntegerValue];
+	}
+
+	if ([keyPath length] == 0) {
+		return NSUndefinedAttributeType;
 	}
 
-	NSString *aggregateString = [self aggregateToString:aggregate];
-	NSAttributeType attributeType = [self attributeTypeWithKey:key error:error];
+	NSArray *keys = [keyPath componentsSeparatedByString:@"."];
 
-	NSEntityDescription *entity = [self entityDescriptionWithError:error]; // [NSEntityDescription entityForName:[self entityName] inManagedObjectContext:[self managedObjectContext]];
-	[fetch setEntity:entity];
-	[fetch setResultType:NSDictionaryResultType];
+	for (NSUInteger i = 0; i + 1 < [keys count]; i++) {
+		entity = [[[entity relationshipsByName] objectForKey:[keys objectAtIndex:i]] destinationEntity];
+	}
+
+	return [[[entity attributesByName] objectForKey:[keys lastObject]] attributeType];
+}
+
++(NSExpressionDescription *)expressionDescriptionWithAggregate:(RHAggregateDescription *)aggregate entity:(NSEntityDescription *)entity {
+	NSExpression *keyPathExpression = [NSExpression expressionForKeyPath:aggregate.key];
+	NSExpression *expression = [NSExpression expressionForFunction:[self aggregateToString:aggregate.aggregate]
+														 arguments:[NSArray arrayWithObject:keyPathExpression]];
 
-	NSExpression *keyPathExpression = [NSExpression expressionForKeyPath:key];
-	NSExpression *expression = [NSExpression expressionForFunction:aggregateString arguments:[NSArray arrayWithObject:keyPathExpression]];
+	NSAttributeType attributeType = [self attributeTypeWithKeyPath:aggregate.key entity:entity];
+
+	if (!aggregate.usesAttributeResultType) {
+		if (aggregate.aggregate == RHAggregateCount) {
+			attributeType = NSInteger64AttributeType;
+		} else if ((aggregate.aggregate == RHAggregateAverage) && (attributeType != NSDecimalAttributeType)) {
+			attributeType = NSDoubleAttributeType;
+		}
+	}
 
 	NSExpressionDescription *expressionDescription = [[NSExpressionDescription alloc] init];
-	[expressionDescription setName:key];
+	[expressionDescription setName:aggregate.name];
 	[expressionDescription setExpression:expression];
 	[expressionDescription setExpressionResultType:attributeType];
 
-	[fetch setPropertiesToFetch:[NSArray arrayWithObject:expressionDescription]];
+	return expressionDescription;
+}
+
++(id)aggregateWithType:(RHAggregate)aggregate
+                   key:(NSString *)key
+             predicate:(NSPredicate *)predicate
+          defaultValue:(id)defaultValue
+                 error:(NSError **)error {
 
-	NSArray *objects = [[self managedObjectContextForCurrentThreadWithError:error] executeFetchRequest:fetch
-                                                                                                 error:error];
+	RHAggregateDescription *aggregateDescription = [RHAggregateDescription aggregateWithType:aggregate key:key name:key];
+	aggregateDescription.usesAttributeResultType = YES;
 
-	id returnValue = nil;
+	NSArray *objects = [self aggregatesWithDescriptions:[NSArray arrayWithObject:aggregateDescription]
+												groupBy:nil
+												 having:nil
+											  predicate:predicate
+												  error:error];
 
-	if ((objects != nil) && ([objects count] > 0) ) {
-		returnValue = [[objects lastObject] valueForKey:key];
-	}
+	id returnValue = [[objects lastObject] valueForKey:key];
 
 	if (returnValue == nil) {
 		returnValue = defaultValue;
@@ -391,23 +1280,281 @@
 	return returnValue;
 }
 
++(NSArray *)aggregatesWithDescriptions:(NSArray *)aggregates
+                               groupBy:(NSArray *)groupByKeyPaths
+                                having:(NSPredicate *)havingPredicate
+                             predicate:(NSPredicate *)predicate
+                                 error:(NSError **)error {
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	CFAbsoluteTime startTime = manager.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	if (moc == nil) {
+		return nil;
+	}
+
+	NSArray *rows = [self aggregateRowsWithDescriptions:aggregates groupBy:groupByKeyPaths having:havingPredicate predicate:predicate error:error];
+
+	if (manager.instrumented && rows) {
+		[manager recordOperation:RHInstrumentationOperationAggregate
+					  entityName:[[self entityDescriptionWithError:nil] name]
+					   predicate:predicate
+					 resultCount:[rows count]
+					   startTime:startTime
+						 context:moc];
+	}
+
+	return rows;
+}
+
++(NSArray *)aggregateRowsWithDescriptions:(NSArray *)aggregates
+                                  groupBy:(NSArray *)groupByKeyPaths
+                                   having:(NSPredicate *)havingPredicate
+                                predicate:(NSPredicate *)predicate
+                                    error:(NSError **)error {
+
+	NSEntityDescription *entity = [self entityDescriptionWithError:error];
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+
+	NSMutableArray *sortDescriptors = [NSMutableArray array];
+	for (NSString *keyPath in groupByKeyPaths) {
+		[sortDescriptors addObject:[NSSortDescriptor sortDescriptorWithKey:keyPath ascending:YES]];
+	}
+
+	NSMutableArray *properties = [NSMutableArray arrayWithArray:groupByKeyPaths];
+	NSMutableArray *distinctAggregates = [NSMutableArray array];
+
+	for (RHAggregateDescription *aggregate in aggregates) {
+		if (aggregate.aggregate == RHAggregateCountDistinct) {
+			[distinctAggregates addObject:aggregate];
+		} else {
+			[properties addObject:[self expressionDescriptionWithAggregate:aggregate entity:entity]];
+		}
+	}
+
+	NSArray *rows = [NSArray arrayWithObject:[NSDictionary dictionary]];
+
+	if ([properties count] > 0) {
+		NSFetchRequest *fetch = [[NSFetchRequest alloc] init];
+
+		[fetch setEntity:entity];
+
+		if (predicate) {
+			[fetch setPredicate:predicate];
+		}
+
+		[fetch setIncludesSubentities:[self shouldFetchRequestsReturnSubentities]];
+		[fetch setResultType:NSDictionaryResultType];
+		[fetch setPropertiesToFetch:properties];
+
+		if ([groupByKeyPaths count] > 0) {
+			[fetch setPropertiesToGroupBy:groupByKeyPaths];
+			[fetch setSortDescriptors:sortDescriptors];
+
+			// With count distinct the having predicate can only be evaluated once all aggregates are known
+			if (havingPredicate && ([distinctAggregates count] == 0)) {
+				[fetch setHavingPredicate:havingPredicate];
+			}
+		}
+
+		rows = [moc executeFetchRequest:fetch error:error];
+
+		if (rows == nil) {
+			return nil;
+		}
+	}
+
+	if ([distinctAggregates count] == 0) {
+		return rows;
+	}
+
+	// The persistent store has no COUNT(DISTINCT), so fetch the distinct (group, value) tuples and count them per group
+	NSMutableArray *results = [NSMutableArray arrayWithCapacity:[rows count]];
+	for (NSDictionary *row in rows) {
+		[results addObject:[row mutableCopy]];
+	}
+
+	for (RHAggregateDescription *aggregate in distinctAggregates) {
+		NSFetchRequest *fetch = [[NSFetchRequest alloc] init];
+
+		[fetch setEntity:entity];
+
+		if (predicate) {
+			[fetch setPredicate:predicate];
+		}
+
+		[fetch setIncludesSubentities:[self shouldFetchRequestsReturnSubentities]];
+		[fetch setResultType:NSDictionaryResultType];
+		[fetch setReturnsDistinctResults:YES];
+		[fetch setPropertiesToFetch:[groupByKeyPaths ? groupByKeyPaths : [NSArray array] arrayByAddingObject:aggregate.key]];
+
+		NSArray *tuples = [moc executeFetchRequest:fetch error:error];
+
+		if (tuples == nil) {
+			return nil;
+		}
+
+		NSCountedSet *counts = [NSCountedSet set];
+
+		for (NSDictionary *tuple in tuples) {
+			if ([tuple objectForKey:aggregate.key]) {
+				[counts addObject:[self groupWithRow:tuple keyPaths:groupByKeyPaths]];
+			}
+		}
+
+		for (NSMutableDictionary *result in results) {
+			[result setObject:[NSNumber numberWithUnsignedInteger:[counts countForObject:[self groupWithRow:result keyPaths:groupByKeyPaths]]]
+					   forKey:aggregate.name];
+		}
+	}
+
+	if (havingPredicate == nil) {
+		return [results copy];
+	}
+
+	NSMutableArray *filteredResults = [NSMutableArray arrayWithCapacity:[results count]];
+
+	for (NSDictionary *result in results) {
+		if ([[havingPredicate predicateWithSubstitutionVariables:result] evaluateWithObject:result]) {
+			[filteredResults addObject:result];
+		}
+	}
+
+	return [filteredResults copy];
+}
+
++(NSArray *)groupWithRow:(NSDictionary *)row keyPaths:(NSArray *)keyPaths {
+	NSMutableArray *group = [NSMutableArray arrayWithCapacity:[keyPaths count]];
+
+	for (NSString *keyPath in keyPaths) {
+		id value = [row objectForKey:keyPath];
+		[group addObject:value ? value : [NSNull null]];
+	}
+
+	return group;
+}
+
++(RHMaterializedAggregate *)materializedCountWithPredicate:(NSPredicate *)predicate
+                                                     error:(NSError **)error {
+	return [self materializedAggregateWithType:RHAggregateCount key:nil predicate:predicate error:error];
+}
+
++(RHMaterializedAggregate *)materializedAggregateWithType:(RHAggregate)aggregate
+                                                      key:(NSString *)key
+                                                predicate:(NSPredicate *)predicate
+                                                    error:(NSError **)error {
+
+	if ((key == nil) && (aggregate != RHAggregateCount)) {
+		if (error) {
+			*error = [NSError errorWithDomain:RHManagedObjectErrorDomain
+										 code:RHManagedObjectErrorInvalidAggregate
+									 userInfo:[NSDictionary dictionaryWithObject:@"Only counts can be materialized without a key." forKey:NSLocalizedDescriptionKey]];
+		}
+		return nil;
+	}
+
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+	RHMaterializedAggregate *materializedAggregate = [[RHMaterializedAggregate alloc] initWithEntityClass:self aggregate:aggregate key:key predicate:predicate];
+
+	for (RHMaterializedAggregate *registeredAggregate in [manager materializedAggregates]) {
+		if ([registeredAggregate isEqualToMaterializedAggregate:materializedAggregate]) {
+			return registeredAggregate;
+		}
+	}
+
+	// Registered first, so commits made while the value is computed are not missed
+	[manager registerMaterializedAggregate:materializedAggregate];
+
+	if (![materializedAggregate recomputeWithError:error]) {
+		[manager unregisterMaterializedAggregate:materializedAggregate];
+		return nil;
+	}
+
+	return materializedAggregate;
+}
+
 +(NSUInteger)deleteAllWithError:(NSError **)error {
     return [self deleteWithPredicate:nil error:error];
 }
 
 +(NSUInteger)deleteWithPredicate:(NSPredicate *)predicate error:(NSError **)error {
-    NSArray *itemsToDelete = [self fetchWithPredicate:predicate error:error];
+	if ([self shouldDeleteInPersistentStore]) {
+		return [self batchDeleteWithPredicate:predicate error:error];
+	}
+
+	// The objects are only deleted, so their attribute values don't need to be loaded
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.includesPropertyValues = NO;
+
+    NSArray *itemsToDelete = [self fetchWithOptions:options error:error];
     [itemsToDelete makeObjectsPerformSelector:@selector(delete)];
     return [itemsToDelete count];
 }
 
+// This can be overridden per subclass
++(BOOL)shouldDeleteInPersistentStore {
+	return NO;
+}
+
++(NSUInteger)batchDeleteWithPredicate:(NSPredicate *)predicate error:(NSError **)error {
+	RHManagedObjectContextManager *manager = [self managedObjectContextManager];
+
+	// NSBatchDeleteRequest is only available on iOS 9 and later, and only for SQLite stores
+	if (@available(iOS 9.0, macOS 10.11, *)) {
+		NSError *storeError = nil;
+
+		if ([manager supportsBatchRequestsForEntity:[self entityDescriptionWithError:nil] error:&storeError]) {
+			NSFetchRequest *fetch = [NSFetchRequest new];
+
+			[fetch setEntity:[self entityDescriptionWithError:error]];
+
+			if (predicate) {
+				[fetch setPredicate:predicate];
+			}
+
+			[fetch setIncludesSubentities:[self shouldFetchRequestsReturnSubentities]];
+
+			NSBatchDeleteRequest *request = [[NSBatchDeleteRequest alloc] initWithFetchRequest:fetch];
+			[request setResultType:NSBatchDeleteResultTypeObjectIDs];
+
+			NSBatchDeleteResult *result = (NSBatchDeleteResult *)[manager executeBatchRequest:request error:error];
+
+			return [[result result] count];
+		}
+
+		// The stores could not be loaded, which is not a reason to fall back
+		if (storeError) {
+			if (error) {
+				*error = storeError;
+			}
+			return 0;
+		}
+	}
+
+	RHFetchOptions *options = [self fetchOptions];
+	options.predicate = predicate;
+	options.includesPropertyValues = NO;
+
+	NSArray *itemsToDelete = [self fetchWithOptions:options error:error];
+	[itemsToDelete makeObjectsPerformSelector:@selector(delete)];
+	return [itemsToDelete count];
+}
+
 // Returns the NSManagedObjectContext for the current thread
 +(NSManagedObjectContext *)managedObjectContextForCurrentThreadWithError:(NSError **)error {
 	return [[self managedObjectContextManager] managedObjectContextForCurrentThreadWithError:error];
 }
 
 +(RHManagedObjectContextManager *)managedObjectContextManager {
-    return [RHManagedObjectContextManager sharedInstanceWithModelName:[self modelName] bundle:[NSBundle bundleForClass:[self class]]];
+	return [[self metadata] manager];
+}
+
++(void)performInBackground:(void (^)(NSManagedObjectContext *moc))block
+                completion:(void (^)(NSError *error))completion {
+
+	[[self managedObjectContextManager] performInBackground:block completion:completion];
 }
 
 +(BOOL)doesRequireMigrationWithError:(NSError **)error {
@@ -415,11 +1562,21 @@
 }
 
 +(void)undo {
-    [[self managedObjectContextForCurrentThreadWithError:nil] undo];
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:nil];
+
+	// Without a context (e.g., while the stores are loading) there is nothing to undo
+	if (moc) {
+		[moc undo];
+	}
 }
 
 +(void)rollback {
-    [[self managedObjectContextForCurrentThreadWithError:nil] rollback];
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:nil];
+
+	// Without a context (e.g., while the stores are loading) there is nothing to roll back
+	if (moc) {
+		[moc rollback];
+	}
 }
 
 -(void)delete {
@@ -453,16 +1610,37 @@
 
 
 +(NSArray*)arrayInCurrentThreadContext:(NSArray *)array {
+	return [self arrayInCurrentThreadContext:array mode:RHContextTransferExisting];
+}
+
++(NSDictionary *)dictionaryInCurrentThreadContext:(NSDictionary *)dictionary {
+	return [self dictionaryInCurrentThreadContext:dictionary mode:RHContextTransferExisting];
+}
+
++(NSSet *)setInCurrentThreadContext:(NSSet*)set {
+	return [self setInCurrentThreadContext:set mode:RHContextTransferExisting];
+}
+
++(NSArray*)arrayInCurrentThreadContext:(NSArray *)array mode:(RHContextTransferMode)mode {
     if (!array) {
         return nil;
 	}
 
+	NSMutableArray *objectIDs = [NSMutableArray arrayWithCapacity:[array count]];
+	for (RHManagedObject *managedObject in array) {
+		if ([managedObject isKindOfClass:[RHManagedObject class]]) {
+			[objectIDs addObject:[managedObject objectID]];
+		}
+	}
+
+	NSDictionary *objectsByID = [self objectsByIDWithObjectIDs:objectIDs mode:mode];
+
     NSMutableArray* tempArray = [NSMutableArray new];
 
     for (RHManagedObject *managedObject in array) {
         if ([managedObject isKindOfClass:[RHManagedObject class]]) {
 
-			RHManagedObject *convertedManagedObject = [managedObject objectInCurrentThreadContextWithError:nil];
+			RHManagedObject *convertedManagedObject = [objectsByID objectForKey:[managedObject objectID]];
 
 			if (convertedManagedObject) {
                 [tempArray addObject:convertedManagedObject];
@@ -477,16 +1655,25 @@
     return [tempArray copy];
 }
 
-+(NSDictionary *)dictionaryInCurrentThreadContext:(NSDictionary *)dictionary {
++(NSDictionary *)dictionaryInCurrentThreadContext:(NSDictionary *)dictionary mode:(RHContextTransferMode)mode {
     if (!dictionary) {
         return nil;
 	}
 
+	NSMutableArray *objectIDs = [NSMutableArray arrayWithCapacity:[dictionary count]];
+	for (RHManagedObject *managedObject in [dictionary allValues]) {
+		if ([managedObject isKindOfClass:[RHManagedObject class]]) {
+			[objectIDs addObject:[managedObject objectID]];
+		}
+	}
+
+	NSDictionary *objectsByID = [self objectsByIDWithObjectIDs:objectIDs mode:mode];
+
     NSMutableDictionary* tempDictionary = [NSMutableDictionary new];
     for (NSString* key in [dictionary allKeys]) {
         RHManagedObject* managedObject = [dictionary objectForKey:key];
         if ([managedObject isKindOfClass:[RHManagedObject class]]) {
-            RHManagedObject* convertedManagedObject = [managedObject objectInCurrentThreadContextWithError:nil];
+            RHManagedObject* convertedManagedObject = [objectsByID objectForKey:[managedObject objectID]];
             if (convertedManagedObject) {
                 [tempDictionary setObject:convertedManagedObject forKey:key];
 			}
@@ -499,15 +1686,139 @@
     return [NSDictionary dictionaryWithDictionary:tempDictionary];
 }
 
-+(NSSet *)setInCurrentThreadContext:(NSSet*)set {
++(NSSet *)setInCurrentThreadContext:(NSSet*)set mode:(RHContextTransferMode)mode {
     if (!set) {
         return nil;
 	}
 
-    NSArray* array = [self arrayInCurrentThreadContext:[set allObjects]];
+    NSArray* array = [self arrayInCurrentThreadContext:[set allObjects] mode:mode];
     return [NSSet setWithArray:array];
 }
 
++(NSArray *)arrayWithObjectIDs:(NSArray *)objectIDs mode:(RHContextTransferMode)mode {
+	if (!objectIDs) {
+		return nil;
+	}
+
+	NSDictionary *objectsByID = [self objectsByIDWithObjectIDs:objectIDs mode:mode];
+	NSMutableArray *objects = [NSMutableArray arrayWithCapacity:[objectIDs count]];
+
+	for (NSManagedObjectID *objectID in objectIDs) {
+		NSManagedObject *object = [objectsByID objectForKey:objectID];
+		if (object) {
+			[objects addObject:object];
+		}
+	}
+
+	return [objects copy];
+}
+
++(NSDictionary *)dictionaryWithObjectIDs:(NSDictionary *)objectIDs mode:(RHContextTransferMode)mode {
+	if (!objectIDs) {
+		return nil;
+	}
+
+	NSDictionary *objectsByID = [self objectsByIDWithObjectIDs:[objectIDs allValues] mode:mode];
+	NSMutableDictionary *objects = [NSMutableDictionary dictionaryWithCapacity:[objectIDs count]];
+
+	for (id key in objectIDs) {
+		NSManagedObject *object = [objectsByID objectForKey:[objectIDs objectForKey:key]];
+		if (object) {
+			[objects setObject:object forKey:key];
+		}
+	}
+
+	return [objects copy];
+}
+
+// Returns the current thread's context of the entity class of an object ID, which need not be this class (e.g., when called on
+// RHManagedObject itself or with objects of different models).  Returns nil while the stores of that class are not loaded.
++(NSManagedObjectContext *)managedObjectContextForObjectID:(NSManagedObjectID *)objectID {
+	Class entityClass = NSClassFromString([[objectID entity] managedObjectClassName]);
+
+	if (![entityClass isSubclassOfClass:[RHManagedObject class]] || (entityClass == [RHManagedObject class])) {
+		entityClass = self;
+	}
+
+	return [entityClass managedObjectContextForCurrentThreadWithError:nil];
+}
+
+// Resolves object IDs in the current thread's context.  Objects that don't exist are left out of the returned dictionary.
++(NSDictionary *)objectsByIDWithObjectIDs:(id<NSFastEnumeration>)objectIDs mode:(RHContextTransferMode)mode {
+	NSMutableDictionary *objectsByID = [NSMutableDictionary dictionary];
+
+	if (mode == RHContextTransferBatchFetch) {
+		NSMutableDictionary *objectIDsByEntity = [NSMutableDictionary dictionary];
+
+		for (NSManagedObjectID *objectID in objectIDs) {
+			NSManagedObjectContext *moc = [self managedObjectContextForObjectID:objectID];
+
+			if (moc == nil) {
+				continue;
+			}
+
+			NSManagedObject *registeredObject = [moc objectRegisteredForID:objectID];
+
+			// Registered objects that are not faults are already loaded (or inserted in this context)
+			if (registeredObject && ![registeredObject isFault]) {
+				[objectsByID setObject:registeredObject forKey:objectID];
+				continue;
+			}
+
+			// Temporary IDs can't be fetched
+			if ([objectID isTemporaryID]) {
+				continue;
+			}
+
+			NSMutableArray *entityObjectIDs = [objectIDsByEntity objectForKey:[[objectID entity] name]];
+			if (entityObjectIDs == nil) {
+				entityObjectIDs = [NSMutableArray array];
+				[objectIDsByEntity setObject:entityObjectIDs forKey:[[objectID entity] name]];
+			}
+			[entityObjectIDs addObject:objectID];
+		}
+
+		for (NSString *entityName in objectIDsByEntity) {
+			NSArray *entityObjectIDs = [objectIDsByEntity objectForKey:entityName];
+			NSManagedObjectContext *moc = [self managedObjectContextForObjectID:[entityObjectIDs objectAtIndex:0]];
+
+			if (moc == nil) {
+				continue;
+			}
+
+			NSFetchRequest *fetch = [NSFetchRequest new];
+			[fetch setEntity:[[entityObjectIDs objectAtIndex:0] entity]];
+			[fetch setPredicate:[NSPredicate predicateWithFormat:@"self IN %@", entityObjectIDs]];
+			[fetch setReturnsObjectsAsFaults:NO];
+
+			for (NSManagedObject *object in [moc executeFetchRequest:fetch error:nil]) {
+				[objectsByID setObject:object forKey:[object objectID]];
+			}
+		}
+	} else {
+		for (NSManagedObjectID *objectID in objectIDs) {
+			NSManagedObjectContext *moc = [self managedObjectContextForObjectID:objectID];
+			NSManagedObject *object;
+
+			if (moc == nil) {
+				continue;
+			}
+
+			if (mode == RHContextTransferFaults) {
+				object = [moc objectWithID:objectID];
+			} else {
+				object = [moc existingObjectWithID:objectID error:nil];
+			}
+
+			if (object) {
+				[objectsByID setObject:object forKey:objectID];
+			}
+		}
+	}
+
+	return objectsByID;
+}
+
 
 
 
@@ -548,6 +1859,58 @@
 @end
 
 
+@implementation RHAggregateDescription
+
++(RHAggregateDescription *)aggregateWithType:(RHAggregate)aggregate key:(NSString *)key {
+	NSString *functionName = nil;
+
+	switch (aggregate) {
+		case RHAggregateMax:
+			functionName = @"max";
+			break;
+		case RHAggregateMin:
+			functionName = @"min";
+			break;
+		case RHAggregateAverage:
+			functionName = @"average";
+			break;
+		case RHAggregateSum:
+			functionName = @"sum";
+			break;
+		case RHAggregateCount:
+			functionName = @"count";
+			break;
+		case RHAggregateCountDistinct:
+			functionName = @"countDistinct";
+			break;
+		default:
+			[NSException raise:NSGenericException format:@"Unexpected FormatType."];
+	}
+
+	// "department.budget" becomes "sumDepartmentBudget"
+	NSMutableString *name = [NSMutableString stringWithString:functionName];
+	for (NSString *component in [key componentsSeparatedByString:@"."]) {
+		if ([component length] > 0) {
+			[name appendString:[[component substringToIndex:1] uppercaseString]];
+			[name appendString:[component substringFromIndex:1]];
+		}
+	}
+
+	return [self aggregateWithType:aggregate key:key name:name];
+}
+
++(RHAggregateDescription *)aggregateWithType:(RHAggregate)aggregate key:(NSString *)key name:(NSString *)name {
+	RHAggregateDescription *aggregateDescription = [[RHAggregateDescription alloc] init];
+	aggregateDescription.aggregate = aggregate;
+	aggregateDescription.key = key;
+	aggregateDescription.name = name;
+	return aggregateDescription;
+}
+
+@end
+
+
+#if TARGET_OS_IPHONE
 @implementation ImageToDataTransformer
 +(BOOL)allowsReverseTransformation {
 	return YES;
@@ -565,3 +1928,4 @@
 	return [UIImage imageWithData:value];
 }
 @end
+#endif
@@ -25,8 +25,55 @@
 #define kMergePolicy NSMergeByPropertyObjectTrumpMergePolicy
 #define RHWillMassUpdateNotification @"RHWillMassUpdateNotification"
 #define kPostMassUpdateNotificationThreshold 10 // If more than kPostMassUpdateNotificationThreshold updates are commited at once, post a RHWillMassUpdateNotification notification first
+#define RHManagedObjectErrorDomain @"RHManagedObjectErrorDomain"
+#define kMergeCoalescingInterval 0.05 // Default number of seconds save notifications are collected before they are merged into the main thread managed object context
+#define kCommitChangeThreshold 100 // Default number of pending changes from which a deferred commit is saved right away
+#define kCommitInterval 1.0 // Default number of seconds a deferred commit waits before it is saved
+#define kMaximumBackgroundContexts 4 // Default number of private queue managed object contexts used by performInBackground:completion:
+#define kStoreLoadingTimeout 10.0 // Default number of seconds a call waits for the persistent stores while they are loaded by loadStoresWithCompletion:
+#define kMainThreadStoreLoadingTimeout 0.0 // Default number of seconds a call on the main thread waits for the persistent stores while they are loaded
+#define kMainStoreConfigurationName @"RHMainStore" // Model configuration the main store is added with when the data model is split over several stores
+
+#define RHDidMergeChangesNotification @"RHDidMergeChangesNotification"
+#define RHMergeDurationKey @"duration"
+#define RHMergeSaveCountKey @"saveCount"
+#define RHMergeObjectCountKey @"objectCount"
+
+#define RHStoresDidLoadNotification @"RHStoresDidLoadNotification"
+#define RHStoreLoadingErrorKey @"error"
+
+#define RHBackgroundTaskCountKey @"taskCount"
+#define RHBackgroundContextCountKey @"contextCount"
+#define RHBackgroundWaitTimeKey @"waitTime"
+#define RHBackgroundExecutionTimeKey @"executionTime"
 
 #import <CoreData/CoreData.h>
+#import "RHInstrumentation.h"
+#import "RHStoreConfiguration.h"
+#import "RHQueryCache.h"
+#import "RHIdentityIndex.h"
+
+@class RHMaterializedAggregate;
+
+typedef enum {
+	RHManagedObjectErrorInvalidRecord = 1,
+	RHManagedObjectErrorFileNotReadable,
+	RHManagedObjectErrorStoreNotReady,
+	RHManagedObjectErrorMigrationFailed,
+	RHManagedObjectErrorInvalidAggregate,
+	RHManagedObjectErrorNoUniqueKey,
+	RHManagedObjectErrorFileNotWritable,
+	RHManagedObjectErrorIndexNotLoaded
+} RHManagedObjectErrorCode;
+
+typedef void (^RHMigrationProgressBlock)(float progress);
+
+typedef enum {
+	RHStoreLoadingStateNotLoaded,
+	RHStoreLoadingStateLoading,
+	RHStoreLoadingStateLoaded,
+	RHStoreLoadingStateFailed
+} RHStoreLoadingState;
 
 
 #pragma mark - RHManagedObjectContextManager interface -
@@ -85,6 +132,52 @@
 
 
 
+#pragma mark - Loading the Persistent Stores
+/**---------------------------------------------------------------------------------------
+ * @name Loading the Persistent Stores
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Loads the data model and the persistent stores on a background queue. This includes copying the seed database and migrating the stores if required. Without this the stores are loaded the first time they are needed, usually on the main thread during launch.
+ *
+ *  Posts an RHStoresDidLoadNotification on the main thread when loading finished, with the error (if any) under RHStoreLoadingErrorKey in the user info. If loading failed, calling this method again retries.
+ *
+ *  @param completion The completion handler that will be executed on the main thread after the stores are loaded. The error is nil if loading succeeded.
+ */
+-(void)loadStoresWithCompletion:(void (^)(NSError *error))completion;
+
+/**
+ *  Loads the data model and the persistent stores on a background queue, like loadStoresWithCompletion:, and reports the progress of a migration of the main store.
+ *
+ *  @param progress   The block that will be executed on the main thread with the progress of the migration between 0 and 1. Only executed if the store is migrated.
+ *  @param completion The completion handler that will be executed on the main thread after the stores are loaded. The error is nil if loading succeeded.
+ *  @see migrateStoreWithProgress:error:
+ */
+-(void)loadStoresWithProgress:(RHMigrationProgressBlock)progress completion:(void (^)(NSError *error))completion;
+
+/**
+ *  Whether the persistent stores are not loaded yet, being loaded, loaded or failed to load. Once loading failed, calls that need the stores return the error right away until loadStoresWithCompletion: is called again.
+ */
+@property (nonatomic, readonly) RHStoreLoadingState storeLoadingState;
+
+/**
+ *  The error of the last failed attempt to load the persistent stores, or nil.
+ */
+@property (nonatomic, readonly) NSError *storeLoadingError;
+
+/**
+ *  The number of seconds a call on a background thread waits for the persistent stores while they are being loaded on another thread, after which it fails with an RHManagedObjectErrorStoreNotReady error. Set to 0 to fail right away. Defaults to 10 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval storeLoadingTimeout;
+
+/**
+ *  The number of seconds a call on the main thread waits for the persistent stores while they are being loaded on another thread, after which it fails with an RHManagedObjectErrorStoreNotReady error. Defaults to 0, so the main thread is never blocked by loadStoresWithCompletion: and shows the data once the completion handler is called.
+ */
+@property (nonatomic, assign) NSTimeInterval mainThreadStoreLoadingTimeout;
+
+
+
 #pragma mark - Getting the Managed Object Context
 /**---------------------------------------------------------------------------------------
  * @name Getting the Managed Object Context
@@ -100,6 +193,47 @@
  */
 -(NSManagedObjectContext *)managedObjectContextForCurrentThreadWithError:(NSError **)error;
 
+/**
+ *  Executes a block synchronously with a new managed object context that is discarded afterwards. While the block is executed, managedObjectContextForCurrentThreadWithError: (and therefore every RHManagedObject class method) returns this managed object context, so the managed object context of the current thread, its objects and its pending changes are left untouched. Changes are not committed automatically; the block commits them itself. Saves are merged into the other managed object contexts as usual.
+ *
+ *  @param block The block to execute. The managed object context must not be used outside of the block.
+ *  @param error If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return YES if the block was executed, NO if the managed object context could not be created.
+ */
+-(BOOL)performWithTemporaryContext:(void (^)(NSManagedObjectContext *moc))block error:(NSError **)error;
+
+
+
+#pragma mark - Performing Work in the Background
+/**---------------------------------------------------------------------------------------
+ * @name Performing Work in the Background
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  The maximum number of blocks executed at once by performInBackground:completion:, and therefore the maximum number of private queue managed object contexts. Defaults to 4.
+ */
+@property (nonatomic, assign) NSUInteger maximumBackgroundContexts;
+
+/**
+ *  Executes a block in the background with a managed object context taken from a pool of private queue managed object contexts. Blocks are queued when all contexts are in use. While the block is executed, managedObjectContextForCurrentThreadWithError: (and therefore every RHManagedObject class method) returns the same managed object context. Changes are committed after the block returns, after which the managed object context is reset and returned to the pool.
+ *
+ *  This is an alternative to running work on arbitrary threads, where a managed object context is created for and kept by each thread.
+ *
+ *  @param block      The block to execute. The managed object context must not be used outside of the block.
+ *  @param completion The completion handler that will be executed on the main thread after the changes are committed. The error is nil if the commit succeeded.
+ */
+-(void)performInBackground:(void (^)(NSManagedObjectContext *moc))block
+                completion:(void (^)(NSError *error))completion;
+
+/**
+ *  Returns statistics about the blocks executed with performInBackground:completion:. The keys are RHBackgroundTaskCountKey (the number of executed blocks), RHBackgroundContextCountKey (the number of managed object contexts created for the pool), RHBackgroundWaitTimeKey (the total time in seconds blocks were queued) and RHBackgroundExecutionTimeKey (the total time in seconds spent executing and committing blocks).
+ *
+ *  @return A dictionary with NSNumber values.
+ */
+-(NSDictionary *)backgroundStatistics;
+
 
 
 #pragma mark - Deleting the Persistent Store
@@ -142,12 +276,36 @@
  */
 
 /**
- *  Attempts to commit unsaved changes to the persistent store.
+ *  Attempts to commit unsaved changes to the persistent store. If defersCommits is YES and this is called on the main thread, the changes are only saved once enough changes are pending or commitInterval has passed.
  *
  *  @return If an error occurs, this returns an NSError object that describes the problem, otherwise nil.
  */
 -(NSError *)commit;
 
+/**
+ *  Attempts to commit unsaved changes to the persistent store right away, regardless of defersCommits.
+ *
+ *  @return If an error occurs, this returns an NSError object that describes the problem, otherwise nil.
+ */
+-(NSError *)commitImmediately;
+
+/**
+ *  Whether or not commit defers saving the main thread managed object context, such that several commits are saved in one transaction with one merge notification. The changes are saved when at least commitChangeThreshold changes are pending, when commitInterval has passed since the first deferred commit, on commitImmediately or flush, and when the application enters the background. If a deferred save fails, the error is returned by the next flush or flushWithCompletion:.
+ *
+ *  Only the main thread managed object context is batched. Commits of the managed object contexts of other threads, including those of performInBackground:completion:, are always saved right away because they can't be saved later from their thread. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL defersCommits;
+
+/**
+ *  The number of pending changes (see pendingChangesCountWithError:) from which a deferred commit is saved right away. Defaults to 100.
+ */
+@property (nonatomic, assign) NSUInteger commitChangeThreshold;
+
+/**
+ *  The number of seconds after the first deferred commit that the changes are saved. Defaults to 1 second.
+ */
+@property (nonatomic, assign) NSTimeInterval commitInterval;
+
 /**
  *  Returns the number of unsaved changes made in the managed object context.
  *
@@ -158,12 +316,219 @@
 -(NSUInteger)pendingChangesCountWithError:(NSError **)error;
 
 /**
- *  This method is called when a commit is performed on a specific managed object context.
+ *  Whether or not changes are written to disk asynchronously. If YES, a private queue writer managed object context owns the persistent store coordinator and all other managed object contexts are its children. commit then returns as soon as the changes reach the writer managed object context, and the writer managed object context saves them to disk in the background. Must be set before the managed object context manager is first used; once managed object contexts exist, changes are ignored (and assert in debug builds). Defaults to NO.
+ *
+ *  Call flush before the application is suspended or terminated.
+ */
+@property (nonatomic, assign) BOOL writesAsynchronously;
+
+/**
+ *  Saves a scheduled deferred commit of the main thread managed object context (if called on the main thread) and waits until all changes committed with writesAsynchronously enabled are written to disk. Changes of the main thread managed object context that were not committed are not saved. Returns immediately if neither defersCommits nor writesAsynchronously are enabled.
+ *
+ *  @return If an error occurs (including an earlier deferred commit or asynchronous write that failed), this returns an NSError object that describes the problem, otherwise nil.
+ */
+-(NSError *)flush;
+
+/**
+ *  Writes all changes committed with writesAsynchronously enabled to disk in the background.
+ *
+ *  @param completion The completion handler that will be executed on the main thread after the changes are written. The error is nil if the write succeeded.
+ */
+-(void)flushWithCompletion:(void (^)(NSError *error))completion;
+
+/**
+ *  This method is called when a commit is performed on a specific managed object context. The changes are collected and merged into the main thread managed object context together with those of other commits within mergeCoalescingInterval.
  *
  *  @param saveNotification The notification responsible for calling this method.
  */
 -(void)mocDidSave:(NSNotification *)saveNotification;
 
+/**
+ *  The number of seconds save notifications of other threads are collected before they are merged into the main thread managed object context in one pass. Defaults to 0.05.
+ */
+@property (nonatomic, assign) NSTimeInterval mergeCoalescingInterval;
+
+/**
+ *  Immediately merges the collected changes of other threads into the main thread managed object context, instead of waiting for mergeCoalescingInterval. Must be called on the main thread. Posts an RHDidMergeChangesNotification with the time spent (RHMergeDurationKey), the number of merged commits (RHMergeSaveCountKey) and the number of changed objects (RHMergeObjectCountKey) in the user info.
+ */
+-(void)mergePendingChanges;
+
+/**
+ *  Registers a fetched results controller on the main thread managed object context. Objects changed in other threads are only loaded into the main thread managed object context when merging if they are already registered there, or if they belong to the entity of a registered fetched results controller. The fetched results controller is not retained. RHCoreDataTableViewController, RHCoreDataCollectionViewController and RHFetchedResultsManager register their fetched results controllers.
+ *
+ *  @param controller The fetched results controller. Its entity must be an RHManagedObject subclass.
+ */
++(void)registerFetchedResultsController:(NSFetchedResultsController *)controller;
+
+
+
+#pragma mark - Caching Query Results
+/**---------------------------------------------------------------------------------------
+ * @name Caching Query Results
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Whether or not the results of RHManagedObject fetches and counts are cached. Fetches cache the object IDs, which are returned as objects of the managed object context of the calling thread (as faults if they are not registered in it yet), and counts cache the count. A cached result is removed when objects of an entity it depends on are saved, changed in the main thread managed object context, or changed in the persistent store (mergeStoreChanges:). The cache is bypassed while the managed object context of the calling thread has unsaved changes, and for fetches with a batch size, properties to fetch or relationship key paths for prefetching. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL cachesQueries;
+
+/**
+ *  The cache used when cachesQueries is YES. Use it to change the capacity (256 results by default) or to read the statistics.
+ */
+@property (nonatomic, readonly) RHQueryCache *queryCache;
+
+/**
+ *  Removes the cached results that depend on the entities of changed objects. Called for commits and merges, and only needs to be called directly after changing the persistent store in other ways.
+ *
+ *  @param changes A dictionary with NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey and/or NSInvalidatedObjectsKey as keys and collections of NSManagedObject or NSManagedObjectID instances as values. NSInvalidatedAllObjectsKey removes all results.
+ */
+-(void)invalidateQueryCacheWithChanges:(NSDictionary *)changes;
+
+
+
+#pragma mark - Materialized Aggregates
+/**---------------------------------------------------------------------------------------
+ * @name Materialized Aggregates
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Registers a materialized aggregate, so its value is updated with every commit and recomputed for changes reported to mergeStoreChanges:. Use materializedAggregateWithType:key:predicate:error: on an RHManagedObject subclass instead of calling this directly.
+ *
+ *  @param aggregate The materialized aggregate.
+ */
+-(void)registerMaterializedAggregate:(RHMaterializedAggregate *)aggregate;
+
+/**
+ *  Stops updating a materialized aggregate.
+ *
+ *  @param aggregate The materialized aggregate.
+ */
+-(void)unregisterMaterializedAggregate:(RHMaterializedAggregate *)aggregate;
+
+/**
+ *  The registered materialized aggregates.
+ *
+ *  @return An array of RHMaterializedAggregate instances.
+ */
+-(NSArray *)materializedAggregates;
+
+
+
+#pragma mark - Identity Indexes
+/**---------------------------------------------------------------------------------------
+ * @name Identity Indexes
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Returns the identity index of an entity, creating it if needed. The index is kept up to date with every save and is loaded again after changes reported to mergeStoreChanges:. Use getWithKey:error: on an RHManagedObject subclass with a uniqueKeyProperty instead of calling this directly.
+ *
+ *  @param entity The entity.
+ *  @param key    The name of the unique key attribute.
+ *
+ *  @return The identity index, which may not be loaded yet.
+ */
+-(RHIdentityIndex *)identityIndexForEntity:(NSEntityDescription *)entity key:(NSString *)key;
+
+
+
+#pragma mark - Merging Changes Made in the Persistent Store
+/**---------------------------------------------------------------------------------------
+ * @name Merging Changes Made in the Persistent Store
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Merges changes that were made directly in the persistent store (e.g., by an NSBatchDeleteRequest) into the main thread managed object context and every managed object context that is kept for a thread. The main thread managed object context is merged asynchronously, the managed object context of the current thread immediately, and the other thread contexts the next time they are used on their thread. Only objects already registered in a managed object context are refreshed or removed, so the didUpdate and didDelete methods are called for those objects only.
+ *
+ *  @param changes A dictionary with NSInsertedObjectsKey, NSUpdatedObjectsKey and/or NSDeletedObjectsKey as keys and arrays of NSManagedObjectID instances as values.
+ */
+-(void)mergeStoreChanges:(NSDictionary *)changes;
+
+/**
+ *  Removes the cached query results, identity indexes and materialized aggregates that depend on an entity whose objects were changed directly in the persistent store without knowing their object IDs (e.g., by an NSBatchInsertRequest with a count result). Managed object contexts are not refreshed.
+ *
+ *  @param entity The changed entity.
+ */
+-(void)persistentStoreDidChangeObjectsOfEntity:(NSEntityDescription *)entity;
+
+/**
+ *  Executes a batch request (NSBatchDeleteRequest, NSBatchUpdateRequest or NSBatchInsertRequest) in the managed object context of the current thread. The request is limited to the persistent stores holding the entity, and asynchronously written changes are flushed to the persistent store first. Object IDs returned by the request are passed to mergeStoreChanges:, and for other result types persistentStoreDidChangeObjectsOfEntity: is called.
+ *
+ *  @param request The batch request.
+ *  @param error   If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return The result of the request, or nil if an error occurred.
+ */
+-(NSPersistentStoreResult *)executeBatchRequest:(NSPersistentStoreRequest *)request error:(NSError **)error;
+
+/**
+ *  Returns whether or not batch requests (NSBatchDeleteRequest, NSBatchUpdateRequest, NSBatchInsertRequest) can be executed for the objects of an entity. This is the case when the persistent stores holding the entity's configuration are SQLite stores, regardless of the type of the other stores. executeBatchRequest:error: limits the request to those stores.
+ *
+ *  @param entity The entity.
+ *  @param error  If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return YES if the persistent stores of the entity support batch requests, otherwise NO.
+ */
+-(BOOL)supportsBatchRequestsForEntity:(NSEntityDescription *)entity error:(NSError **)error;
+
+
+
+#pragma mark - Instrumentation
+/**---------------------------------------------------------------------------------------
+ * @name Instrumentation
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  A block that receives an RHInstrumentationEvent for every fetch, count, aggregate, commit, merge and managed object context creation. The block is executed synchronously on the thread of the operation, so it should return quickly. Defaults to nil.
+ */
+@property (nonatomic, copy) RHInstrumentationBlock instrumentationBlock;
+
+/**
+ *  Whether or not the durations of operations are collected in histograms per entity and operation. Defaults to NO.
+ *  @see histogramsForEntityName:
+ */
+@property (nonatomic, assign) BOOL collectsHistograms;
+
+/**
+ *  Whether or not an instrumentation block is set or histograms are collected. Operations are only timed if this is YES, so instrumentation costs nothing otherwise.
+ */
+@property (nonatomic, readonly, getter=isInstrumented) BOOL instrumented;
+
+/**
+ *  Records an operation. Called by RHManagedObject and RHManagedObjectContextManager, and only needs to be called directly to instrument custom operations. Does nothing if isInstrumented is NO.
+ *
+ *  @param operation   The type of operation.
+ *  @param entityName  The name of the entity, or nil.
+ *  @param predicate   The predicate, or nil.
+ *  @param resultCount The number of results or changed objects.
+ *  @param startTime   The time the operation started, from CFAbsoluteTimeGetCurrent().
+ *  @param moc         The managed object context the operation was performed in.
+ */
+-(void)recordOperation:(RHInstrumentationOperation)operation
+            entityName:(NSString *)entityName
+             predicate:(NSPredicate *)predicate
+           resultCount:(NSUInteger)resultCount
+             startTime:(CFAbsoluteTime)startTime
+               context:(NSManagedObjectContext *)moc;
+
+/**
+ *  Returns the histograms collected for an entity while collectsHistograms was enabled. Each histogram covers the last one to two minutes.
+ *
+ *  @param entityName The name of the entity, or nil for the creation of managed object contexts. Commits and merges are recorded for each entity with changes, with the number of changed objects of that entity as result count and the duration of the whole commit or merge.
+ *
+ *  @return A dictionary with the names of the operations (see RHInstrumentationEvent nameOfOperation:) as keys and copies of the RHInstrumentationHistogram instances as values.
+ */
+-(NSDictionary *)histogramsForEntityName:(NSString *)entityName;
+
+/**
+ *  Removes all collected histograms.
+ */
+-(void)resetHistograms;
+
 
 
 #pragma mark - Data Model Migration
@@ -181,6 +546,25 @@
  */
 -(BOOL)doesRequireMigrationWithError:(NSError **)error;
 
+/**
+ *  Migrates the main SQLite store to the current data model one model version at a time, e.g., from SimplifiedCoreDataExample to SimplifiedCoreDataExample2 and then to the next version. The versions are the models in the .momd directory of the data model, in the order of their names. Each step uses the mapping model in the bundle of the data model if there is one, and an inferred (lightweight) mapping otherwise. Lightweight steps are performed in place by SQLite, so memory usage does not depend on the size of the store. Steps with a mapping model migrate into a new file in one pass per entity mapping (entity mappings of related entities share a pass, since relationships are only resolved within a pass), so memory usage is bounded by the objects of the largest group of related entities rather than the whole store.
+ *
+ *  This is called when the stores are loaded, so it is usually not called directly. It must not be called while the store is in use.
+ *
+ *  @param progress The block that will be executed on the main thread with the overall progress between 0 and 1, or nil.
+ *  @param error    If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return YES if the store was migrated or did not require migration, otherwise NO. A failed step leaves the store at the last completed version.
+ */
+-(BOOL)migrateStoreWithProgress:(RHMigrationProgressBlock)progress error:(NSError **)error;
+
+/**
+ *  Returns the versions of the data model, in the order they are migrated.
+ *
+ *  @return An array of NSManagedObjectModel instances, or an empty array if the data model is not versioned.
+ */
+-(NSArray *)modelVersions;
+
 
 
 #pragma mark - Database Storage
@@ -203,6 +587,43 @@
  */
 -(NSString *)applicationCachesDirectory;
 
+/**
+ *  Registers the store configuration for a data model. Must be called before the data model is first used. The configuration is copied and used by every managed object context manager created for the data model, including those created after deleteStore.
+ *
+ *  @param configuration The store configuration, or nil to use the defaults.
+ *  @param modelName     The name of the data model.
+ */
++(void)setStoreConfiguration:(RHStoreConfiguration *)configuration forModelName:(NSString *)modelName;
+
+/**
+ *  Registers several store configurations for a data model, one per persistent store. Every store except the main store must set configurationName, and either entityNames or a configuration with that name in the data model. The main store (the one without a configurationName) holds all remaining entities. Fetches and commits span all stores.
+ *
+ *  @param configurations An array of RHStoreConfiguration instances, or nil to use the defaults.
+ *  @param modelName      The name of the data model.
+ */
++(void)setStoreConfigurations:(NSArray *)configurations forModelName:(NSString *)modelName;
+
+/**
+ *  The store configurations of the data model, one per persistent store. Defaults to the configurations registered with setStoreConfigurations:forModelName:, or a single default configuration if none are registered. Can also be set directly before the managed object context manager is first used.
+ */
+@property (nonatomic, copy) NSArray *storeConfigurations;
+
+/**
+ *  Returns the configuration of the main store: the one without a configurationName, or the first. storePath, storeURL and doesRequireMigrationWithError: refer to this store.
+ *
+ *  @return The store configuration.
+ */
+-(RHStoreConfiguration *)mainStoreConfiguration;
+
+/**
+ *  Returns the file URL of the database of a store.
+ *
+ *  @param configuration One of the storeConfigurations.
+ *
+ *  @return The file URL, or nil for stores that are not SQLite stores.
+ */
+-(NSURL *)storeURLForConfiguration:(RHStoreConfiguration *)configuration;
+
 -(NSString *)storePath;
 -(NSURL *)storeURL;
 -(NSString *)databaseName;
@@ -213,6 +634,11 @@
  *  ---------------------------------------------------------------------------------------
  */
 
+/**
+ *  The managed object model. Defaults to the compiled model named after the data model in the bundle of the data model. A programmatically constructed model can be set before the managed object context manager is first used.
+ */
+@property (nonatomic, strong) NSManagedObjectModel *managedObjectModel;
+
 /**
  *  Returns all entities.
  *
@@ -220,4 +646,13 @@
  */
 -(NSArray *)entities;
 
+/**
+ *  Returns the entity description for a specific entity in the managed object model.
+ *
+ *  @param entityName The name of the entity.
+ *
+ *  @return The entity description or nil if the entity does not exist.
+ */
+-(NSEntityDescription *)entityForName:(NSString *)entityName;
+
 @end
@@ -24,13 +24,65 @@
 
 #import "RHManagedObjectContextManager.h"
 #import "RHManagedObject.h"
+#import "RHMaterializedAggregate.h"
+
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#endif
+
+#define kMaximumPendingStoreChanges 10000 // Object IDs queued for a thread context before the queue is dropped and the context refreshed instead
 
 @interface RHManagedObjectContext : NSManagedObjectContext
 @property (nonatomic, weak) id observer;
+@property (nonatomic, strong) NSMutableArray *pendingStoreChanges;
+@property (nonatomic, assign) NSUInteger pendingStoreChangeCount;
+@property (nonatomic, assign) BOOL needsStoreRefresh;
+-(void)enqueueStoreChanges:(NSDictionary *)changes;
+-(NSArray *)dequeueStoreChanges:(BOOL *)needsRefresh;
 @end
 
 @implementation RHManagedObjectContext
 
+// Changes made directly in the store (batch requests) can be reported from any thread, but a confined context may only be
+// touched from its own thread.  They are queued here and merged the next time the context is handed out on its thread.
+-(void)enqueueStoreChanges:(NSDictionary *)changes {
+	@synchronized(self) {
+		// A context whose thread doesn't use it for a while would otherwise hold every ID of every batch request
+		if (self.needsStoreRefresh) {
+			return;
+		}
+
+		for (NSString *key in changes) {
+			self.pendingStoreChangeCount += [[changes objectForKey:key] count];
+		}
+
+		if (self.pendingStoreChangeCount > kMaximumPendingStoreChanges) {
+			self.pendingStoreChanges = nil;
+			self.pendingStoreChangeCount = 0;
+			self.needsStoreRefresh = YES;
+			return;
+		}
+
+		if (self.pendingStoreChanges == nil) {
+			self.pendingStoreChanges = [NSMutableArray array];
+		}
+		[self.pendingStoreChanges addObject:changes];
+	}
+}
+
+-(NSArray *)dequeueStoreChanges:(BOOL *)needsRefresh {
+	@synchronized(self) {
+		NSArray *changes = self.pendingStoreChanges;
+		*needsRefresh = self.needsStoreRefresh;
+
+		self.pendingStoreChanges = nil;
+		self.pendingStoreChangeCount = 0;
+		self.needsStoreRefresh = NO;
+
+		return changes;
+	}
+}
+
 // This subclass is for managing the NSManagedObjectContextDidSaveNotification.  The ManagedObjectContext is deallocated at an undetermined
 // time when the thread on which it was allocated cleans up the threadDictionary.  By putting the removeObserver in the dealloc we can be
 // certain everything is cleaned up when it's no longer required.
@@ -58,17 +110,82 @@
 @end
 
 
+// Forwards the progress of an NSMigrationManager, which is only observable with KVO
+@interface RHMigrationProgressObserver : NSObject
+@property (nonatomic, copy) RHMigrationProgressBlock progressBlock;
+@end
+
+@implementation RHMigrationProgressObserver
+
+-(void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+	if (self.progressBlock) {
+		self.progressBlock([object migrationProgress]);
+	}
+}
+
+@end
+
+
 @interface RHManagedObjectContextManager()
 
 @property (nonatomic, strong) NSManagedObjectContext *managedObjectContextForMainThread;
-@property (nonatomic, strong) NSManagedObjectModel *managedObjectModel;
 @property (nonatomic, strong) NSPersistentStoreCoordinator *persistentStoreCoordinator;
 @property (nonatomic, strong) NSString *modelName;
 @property (nonatomic, strong) NSBundle *bundle;
 @property (nonatomic, strong) NSString *guid;
 @property (nonatomic, strong) id localChangeObserver;
+@property (nonatomic, strong) NSHashTable *threadContexts;
+@property (nonatomic, strong) NSCondition *storeLoadingCondition;
+@property (nonatomic, readwrite) RHStoreLoadingState storeLoadingState;
+@property (nonatomic, readwrite, strong) NSError *storeLoadingError;
+@property (nonatomic, strong) NSManagedObjectContext *writerContext;
+@property (nonatomic, strong) NSError *asynchronousWriteError;
+@property (nonatomic, assign) BOOL commitScheduled;
+@property (nonatomic, strong) NSError *asynchronousCommitError;
+@property (nonatomic, strong) NSMutableDictionary *pendingSaveChanges;
+@property (nonatomic, assign) NSUInteger pendingSaveCount;
+@property (nonatomic, assign) BOOL mergeScheduled;
+@property (nonatomic, strong) NSHashTable *fetchedResultsControllers;
+@property (nonatomic, strong) NSOperationQueue *backgroundQueue;
+@property (nonatomic, strong) NSMutableArray *idleBackgroundContexts;
+@property (nonatomic, assign) NSUInteger backgroundTaskCount;
+@property (nonatomic, assign) NSUInteger backgroundContextCount;
+@property (nonatomic, assign) NSTimeInterval backgroundWaitTime;
+@property (nonatomic, assign) NSTimeInterval backgroundExecutionTime;
+@property (nonatomic, readwrite, getter=isInstrumented) BOOL instrumented;
+@property (nonatomic, strong) NSMutableDictionary *histograms;
+@property (nonatomic, readwrite, strong) RHQueryCache *queryCache;
+@property (nonatomic, strong) NSMutableArray *materializedAggregateList;
+@property (nonatomic, strong) NSMutableDictionary *identityIndexes;
 
 +(NSMutableDictionary *)sharedInstances;
++(NSMutableDictionary *)registeredStoreConfigurations;
+-(NSString *)configurationNameForStore:(RHStoreConfiguration *)configuration model:(NSManagedObjectModel *)model;
+-(void)setEntities:(NSArray *)entities forConfigurationName:(NSString *)configurationName model:(NSManagedObjectModel *)model;
+-(NSPersistentStoreCoordinator *)persistentStoreCoordinatorWaitingUntilDate:(NSDate *)deadline retry:(BOOL)retry progress:(RHMigrationProgressBlock)progress error:(NSError **)error;
+-(NSPersistentStoreCoordinator *)newPersistentStoreCoordinatorWithProgress:(RHMigrationProgressBlock)progress error:(NSError **)error;
+-(BOOL)migrateStoreAtURL:(NSURL *)storeURL fromModel:(NSManagedObjectModel *)sourceModel toModel:(NSManagedObjectModel *)destinationModel progress:(RHMigrationProgressBlock)progress error:(NSError **)error;
+-(NSError *)migrationErrorWithDescription:(NSString *)description;
+-(NSError *)moveStoreFiles:(NSString *)storePath toPath:(NSString *)destinationPath;
+-(NSArray *)mappingModelPassesForMappingModel:(NSMappingModel *)mappingModel sourceModel:(NSManagedObjectModel *)sourceModel destinationModel:(NSManagedObjectModel *)destinationModel;
+-(void)mergeStoreChanges:(NSDictionary *)changes intoContext:(NSManagedObjectContext *)moc;
+-(void)mergeQueuedStoreChangesIntoContext:(RHManagedObjectContext *)moc;
+-(NSString *)backgroundContextKey;
+-(BOOL)attachContext:(NSManagedObjectContext *)moc error:(NSError **)error;
+-(void)faultInObjectIDs:(NSArray *)objectIDs context:(NSManagedObjectContext *)moc;
+-(void)saveWriterContext;
+-(NSError *)saveScheduledCommit;
+-(NSError *)dequeueAsynchronousCommitError;
+-(NSError *)saveContext:(NSManagedObjectContext *)moc;
+-(void)applicationDidEnterBackground:(NSNotification *)notification;
+-(RHManagedObjectContext *)dequeueBackgroundContextWithError:(NSError **)error;
+-(void)updateInstrumented;
+-(void)recordOperation:(RHInstrumentationOperation)operation changeCounts:(NSDictionary *)changeCounts startTime:(CFAbsoluteTime)startTime context:(NSManagedObjectContext *)moc;
+-(NSDictionary *)changeCountsByEntityNameInSets:(NSArray *)sets;
+-(NSSet *)entityNamesWithChanges:(NSDictionary *)changes;
+-(void)updateIdentityIndexesWithChanges:(NSDictionary *)changes;
+-(void)updateIdentityIndexesWithStoreChanges:(NSDictionary *)changes;
+-(NSArray *)persistentStoresForEntity:(NSEntityDescription *)entity error:(NSError **)error;
 
 @end
 
@@ -78,6 +195,7 @@
 // @synthesize persistentStoreCoordinator;
 // @synthesize modelName;
 // @synthesize guid;
+@synthesize instrumentationBlock = _instrumentationBlock;
 
 #pragma mark -
 #pragma mark Singleton Methods
@@ -86,12 +204,16 @@
 }
 
 +(RHManagedObjectContextManager *)sharedInstanceWithModelName:(NSString *)modelName bundle:(NSBundle *)bundle {
-    if ([[self sharedInstances] objectForKey:modelName] == nil) {
-        RHManagedObjectContextManager *contextManager = [[RHManagedObjectContextManager alloc] initWithModelName:modelName bundle:bundle];
-        [[self sharedInstances] setObject:contextManager forKey:modelName];
-    }
-    
-    return [[self sharedInstances] objectForKey:modelName];
+	NSMutableDictionary *sharedInstances = [self sharedInstances];
+
+	@synchronized(sharedInstances) {
+		if ([sharedInstances objectForKey:modelName] == nil) {
+			RHManagedObjectContextManager *contextManager = [[RHManagedObjectContextManager alloc] initWithModelName:modelName bundle:bundle];
+			[sharedInstances setObject:contextManager forKey:modelName];
+		}
+
+		return [sharedInstances objectForKey:modelName];
+	}
 }
 
 +(NSMutableDictionary *)sharedInstances {
@@ -103,6 +225,31 @@
     return sharedInstances;
 }
 
++(NSMutableDictionary *)registeredStoreConfigurations {
+    static dispatch_once_t once;
+    static NSMutableDictionary *registeredStoreConfigurations;
+    dispatch_once(&once, ^{
+        registeredStoreConfigurations = [[NSMutableDictionary alloc] init];
+    });
+    return registeredStoreConfigurations;
+}
+
++(void)setStoreConfiguration:(RHStoreConfiguration *)configuration forModelName:(NSString *)modelName {
+	[self setStoreConfigurations:configuration ? [NSArray arrayWithObject:configuration] : nil forModelName:modelName];
+}
+
++(void)setStoreConfigurations:(NSArray *)configurations forModelName:(NSString *)modelName {
+	NSMutableDictionary *registeredStoreConfigurations = [self registeredStoreConfigurations];
+
+	@synchronized(registeredStoreConfigurations) {
+		if ([configurations count] > 0) {
+			[registeredStoreConfigurations setObject:[[NSArray alloc] initWithArray:configurations copyItems:YES] forKey:modelName];
+		} else {
+			[registeredStoreConfigurations removeObjectForKey:modelName];
+		}
+	}
+}
+
 +(NSError *)deleteFile:(NSString *)filePath {
 	NSFileManager *fm = [NSFileManager defaultManager];
 	NSError *error;
@@ -118,6 +265,38 @@
     if (self=[super init]) {
         self.modelName = modelName;
         self.bundle = bundle;
+		self.threadContexts = [NSHashTable weakObjectsHashTable];
+		self.storeLoadingCondition = [[NSCondition alloc] init];
+		self.storeLoadingTimeout = kStoreLoadingTimeout;
+		self.mainThreadStoreLoadingTimeout = kMainThreadStoreLoadingTimeout;
+		self.fetchedResultsControllers = [NSHashTable weakObjectsHashTable];
+		self.pendingSaveChanges = [NSMutableDictionary dictionary];
+		self.mergeCoalescingInterval = kMergeCoalescingInterval;
+		self.commitChangeThreshold = kCommitChangeThreshold;
+		self.commitInterval = kCommitInterval;
+
+		NSMutableDictionary *registeredStoreConfigurations = [RHManagedObjectContextManager registeredStoreConfigurations];
+		@synchronized(registeredStoreConfigurations) {
+			self.storeConfigurations = [registeredStoreConfigurations objectForKey:modelName];
+		}
+
+		if (self.storeConfigurations == nil) {
+			self.storeConfigurations = [NSArray arrayWithObject:[[RHStoreConfiguration alloc] init]];
+		}
+
+#if TARGET_OS_IPHONE
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(applicationDidEnterBackground:)
+													 name:UIApplicationDidEnterBackgroundNotification
+												   object:nil];
+#endif
+		self.idleBackgroundContexts = [NSMutableArray array];
+		self.backgroundQueue = [[NSOperationQueue alloc] init];
+		self.maximumBackgroundContexts = kMaximumBackgroundContexts;
+		self.histograms = [NSMutableDictionary dictionary];
+		self.queryCache = [[RHQueryCache alloc] initWithCapacity:kQueryCacheCapacity];
+		self.materializedAggregateList = [NSMutableArray array];
+		self.identityIndexes = [NSMutableDictionary dictionary];
     }
     return self;
 }
@@ -130,10 +309,20 @@
     
     [self.managedObjectContextForMainThread reset];
 
+	// Waits for pending asynchronous writes, which are discarded
+	NSManagedObjectContext *writerContext = self.writerContext;
+	[writerContext performBlockAndWait:^{
+		[writerContext reset];
+	}];
+
 	if (_persistentStoreCoordinator == nil) {
         
-		NSString *storePath = [self storePath];
-		[self deleteStoreFiles:storePath];
+		// An in-memory store has no files
+		for (RHStoreConfiguration *configuration in self.storeConfigurations) {
+			if ([configuration isSQLiteStore]) {
+				[self deleteStoreFiles:[[self storeURLForConfiguration:configuration] path]];
+			}
+		}
 
 	} else {
 
@@ -155,12 +344,44 @@
 		}
 	}
 
+	@synchronized(self.threadContexts) {
+		[self.threadContexts removeAllObjects];
+	}
+
+	@synchronized(self.idleBackgroundContexts) {
+		[self.idleBackgroundContexts removeAllObjects];
+	}
+
+	@synchronized(self.pendingSaveChanges) {
+		[self.pendingSaveChanges removeAllObjects];
+		self.pendingSaveCount = 0;
+	}
+
 	self.managedObjectContextForMainThread = nil;
+	self.writerContext = nil;
+	self.asynchronousWriteError = nil;
+	[self dequeueAsynchronousCommitError];
 	self.managedObjectModel = nil;
 	self.persistentStoreCoordinator = nil;
 	self.guid = nil;
+	[self.queryCache removeAllObjects];
+	[[self materializedAggregates] makeObjectsPerformSelector:@selector(setNeedsRecompute)];
+
+	@synchronized(self.identityIndexes) {
+		[self.identityIndexes removeAllObjects];
+	}
+
+	[self.storeLoadingCondition lock];
+	self.storeLoadingState = RHStoreLoadingStateNotLoaded;
+	self.storeLoadingError = nil;
+	[self.storeLoadingCondition unlock];
 
-	[[RHManagedObjectContextManager sharedInstances] removeObjectForKey:[self modelName]];
+	NSMutableDictionary *sharedInstances = [RHManagedObjectContextManager sharedInstances];
+	@synchronized(sharedInstances) {
+		[sharedInstances removeObjectForKey:[self modelName]];
+	}
+
+	[RHManagedObject invalidateCachedMetadataForContextManager:self];
 
     return nil;
 }
@@ -205,6 +426,76 @@
         return error;
     }
 
+	// Deferred commits only apply to the main thread context, the only one that is guaranteed to be used again later
+	if (self.defersCommits && (moc == _managedObjectContextForMainThread)) {
+		NSUInteger pendingChangesCount = [self pendingChangesCountWithError:&error];
+
+		if (error) {
+			return error;
+		}
+
+		if ((pendingChangesCount > 0) && (pendingChangesCount < self.commitChangeThreshold)) {
+			if (!self.commitScheduled) {
+				self.commitScheduled = YES;
+
+				dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.commitInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+					NSError *commitError = [self saveScheduledCommit];
+
+					// The caller of commit was told the changes are saved, so the failure is kept for flush
+					if (commitError) {
+						NSLog(@"Unresolved error %@, %@", commitError, [commitError userInfo]);
+
+						@synchronized(self) {
+							self.asynchronousCommitError = commitError;
+						}
+					}
+				});
+			}
+
+			return nil;
+		}
+	}
+
+	return [self saveContext:moc];
+}
+
+// Saves the main thread context if a deferred commit is waiting for it.  Must be called on the main thread.
+-(NSError *)saveScheduledCommit {
+	if (!self.commitScheduled || (_managedObjectContextForMainThread == nil)) {
+		self.commitScheduled = NO;
+		return nil;
+	}
+
+	// saveContext: clears commitScheduled
+	return [self saveContext:_managedObjectContextForMainThread];
+}
+
+-(NSError *)dequeueAsynchronousCommitError {
+	@synchronized(self) {
+		NSError *error = self.asynchronousCommitError;
+		self.asynchronousCommitError = nil;
+		return error;
+	}
+}
+
+-(NSError *)commitImmediately {
+	NSError *error = nil;
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:&error];
+
+	if (error) {
+		return error;
+	}
+
+	return [self saveContext:moc];
+}
+
+-(NSError *)saveContext:(NSManagedObjectContext *)moc {
+	NSError *error = nil;
+
+	if (moc == _managedObjectContextForMainThread) {
+		self.commitScheduled = NO;
+	}
+
 	if ([self pendingChangesCountWithError:&error] > kPostMassUpdateNotificationThreshold) {
 		[[NSNotificationCenter defaultCenter] postNotificationName:RHWillMassUpdateNotification
                                                             object:nil];
@@ -214,20 +505,229 @@
         return error;
     }
 
-	if ([moc hasChanges] && ![moc save:&error]) {
-		NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
-		return error;
+	if ([moc hasChanges]) {
+		CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+		// Saves of the main thread managed object context are not observed by mocDidSave:
+		NSDictionary *changes = nil;
+		if ((moc == _managedObjectContextForMainThread) && (self.cachesQueries || [self.identityIndexes count] > 0)) {
+			changes = [NSDictionary dictionaryWithObjectsAndKeys:
+					   [moc insertedObjects], NSInsertedObjectsKey,
+					   [moc updatedObjects], NSUpdatedObjectsKey,
+					   [moc deletedObjects], NSDeletedObjectsKey, nil];
+		}
+
+		// The changes must be collected before the save, while the committed values are still the old ones
+		NSMapTable *aggregateChanges = [NSMapTable strongToStrongObjectsMapTable];
+		for (RHMaterializedAggregate *aggregate in [self materializedAggregates]) {
+			id changes = [aggregate changesInContext:moc];
+
+			if (changes) {
+				[aggregateChanges setObject:changes forKey:aggregate];
+			}
+		}
+
+		NSDictionary *changeCounts = self.instrumented ? [self changeCountsByEntityNameInSets:[NSArray arrayWithObjects:[moc insertedObjects], [moc updatedObjects], [moc deletedObjects], nil]] : nil;
+
+		// With a writer context the other contexts only see this save through the parent, so they must agree on the object IDs
+		if (self.writerContext && ([[moc insertedObjects] count] > 0) && ![moc obtainPermanentIDsForObjects:[[moc insertedObjects] allObjects] error:&error]) {
+			for (RHMaterializedAggregate *aggregate in aggregateChanges) {
+				[aggregate discardChanges:[aggregateChanges objectForKey:aggregate]];
+			}
+			return error;
+		}
+
+		if (![moc save:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+			for (RHMaterializedAggregate *aggregate in aggregateChanges) {
+				[aggregate discardChanges:[aggregateChanges objectForKey:aggregate]];
+			}
+			return error;
+		}
+
+		[self invalidateQueryCacheWithChanges:changes];
+		[self updateIdentityIndexesWithChanges:changes];
+
+		for (RHMaterializedAggregate *aggregate in aggregateChanges) {
+			[aggregate applyChanges:[aggregateChanges objectForKey:aggregate]];
+		}
+
+		if (self.instrumented) {
+			[self recordOperation:RHInstrumentationOperationCommit changeCounts:changeCounts startTime:startTime context:moc];
+		}
 	}
+
+	[self saveWriterContext];
+
     return nil;
 }
 
+#pragma mark -
+#pragma mark Asynchronous writes
+// Existing managed object contexts are attached to either the coordinator or the writer context, which can't be changed afterwards
+-(void)setWritesAsynchronously:(BOOL)writesAsynchronously {
+	if (writesAsynchronously == _writesAsynchronously) {
+		return;
+	}
+
+	BOOL contextsExist = (_managedObjectContextForMainThread != nil) || (self.writerContext != nil);
+
+	@synchronized(self.threadContexts) {
+		contextsExist = contextsExist || ([[self.threadContexts allObjects] count] > 0);
+	}
+
+	NSAssert(!contextsExist, @"writesAsynchronously must be set before the managed object context manager is first used.");
+
+	if (contextsExist) {
+		NSLog(@"Ignoring writesAsynchronously, since managed object contexts already exist.");
+		return;
+	}
+
+	_writesAsynchronously = writesAsynchronously;
+}
+
+-(BOOL)attachContext:(NSManagedObjectContext *)moc error:(NSError **)error {
+	if (!self.writesAsynchronously) {
+		NSPersistentStoreCoordinator *coordinator = [self persistentStoreCoordinatorWithError:error];
+		[moc setPersistentStoreCoordinator:coordinator];
+		return (coordinator != nil);
+	}
+
+	// Outside of the lock, since loading the stores needs it for the managed object model
+	NSPersistentStoreCoordinator *coordinator = [self persistentStoreCoordinatorWithError:error];
+
+	if (coordinator == nil) {
+		return NO;
+	}
+
+	@synchronized(self) {
+		if (self.writerContext == nil) {
+			CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+			NSManagedObjectContext *writerContext = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSPrivateQueueConcurrencyType];
+			[writerContext setPersistentStoreCoordinator:coordinator];
+			[writerContext setMergePolicy:kMergePolicy];
+			self.writerContext = writerContext;
+
+			if (self.instrumented) {
+				[self recordOperation:RHInstrumentationOperationContextCreation entityName:nil predicate:nil resultCount:0 startTime:startTime context:writerContext];
+			}
+		}
+	}
+
+	[moc setParentContext:self.writerContext];
+	return YES;
+}
+
+-(void)saveWriterContext {
+	NSManagedObjectContext *writerContext = self.writerContext;
+
+	[writerContext performBlock:^{
+		NSError *error = nil;
+
+		if ([writerContext hasChanges] && ![writerContext save:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+			self.asynchronousWriteError = error;
+		}
+	}];
+}
+
+-(NSError *)flush {
+	NSManagedObjectContext *writerContext = self.writerContext;
+
+	// Only a scheduled deferred commit is saved, uncommitted changes of the main thread context are left alone
+	__block NSError *error = [NSThread isMainThread] ? [self saveScheduledCommit] : nil;
+	NSError *commitError = [self dequeueAsynchronousCommitError];
+
+	if (error == nil) {
+		error = commitError;
+	}
+
+	if (error) {
+		return error;
+	}
+
+	// Blocks are executed in order, so this runs after every pending asynchronous write
+	[writerContext performBlockAndWait:^{
+		if ([writerContext hasChanges] && ![writerContext save:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		}
+
+		if (error == nil) {
+			error = self.asynchronousWriteError;
+		}
+
+		self.asynchronousWriteError = nil;
+	}];
+
+	return error;
+}
+
+-(void)flushWithCompletion:(void (^)(NSError *error))completion {
+	NSManagedObjectContext *writerContext = self.writerContext;
+
+	// Only a scheduled deferred commit is saved, uncommitted changes of the main thread context are left alone
+	NSError *commitError = [NSThread isMainThread] ? [self saveScheduledCommit] : nil;
+	NSError *previousCommitError = [self dequeueAsynchronousCommitError];
+
+	if (commitError == nil) {
+		commitError = previousCommitError;
+	}
+
+	if (commitError) {
+		if (completion) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(commitError);
+			});
+		}
+		return;
+	}
+
+	if (writerContext == nil) {
+		if (completion) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(nil);
+			});
+		}
+		return;
+	}
+
+	[writerContext performBlock:^{
+		NSError *error = nil;
+
+		if ([writerContext hasChanges] && ![writerContext save:&error]) {
+			NSLog(@"Unresolved error %@, %@", error, [error userInfo]);
+		}
+
+		if (error == nil) {
+			error = self.asynchronousWriteError;
+		}
+
+		self.asynchronousWriteError = nil;
+
+		if (completion) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(error);
+			});
+		}
+	}];
+}
+
 #pragma mark -
 #pragma mark Core Data stack
 -(NSManagedObjectContext *)managedObjectContextForMainThreadWithError:(NSError **)error {
 	if (_managedObjectContextForMainThread == nil) {
 		NSAssert([NSThread isMainThread], @"Must be instantiated on main thread.");
-        self.managedObjectContextForMainThread = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSConfinementConcurrencyType];
-		[_managedObjectContextForMainThread setPersistentStoreCoordinator:[self persistentStoreCoordinatorWithError:error]];
+		CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+		NSManagedObjectContext *moc = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSConfinementConcurrencyType];
+
+		// Without persistent stores there is no usable context, and none is kept so the next call tries again
+		if (![self attachContext:moc error:error]) {
+			return nil;
+		}
+
+        self.managedObjectContextForMainThread = moc;
 		[_managedObjectContextForMainThread setMergePolicy:kMergePolicy];
 
 		self.localChangeObserver = [[NSNotificationCenter defaultCenter]
@@ -248,7 +748,13 @@
 										NSSet *deletedObjects = [[notification userInfo] objectForKey:NSDeletedObjectsKey];
 										[deletedObjects makeObjectsPerformSelector:@selector(didDelete)];
 
+										[self invalidateQueryCacheWithChanges:[notification userInfo]];
+
 									}];
+
+		if (self.instrumented) {
+			[self recordOperation:RHInstrumentationOperationContextCreation entityName:nil predicate:nil resultCount:0 startTime:startTime context:_managedObjectContextForMainThread];
+		}
 	}
 
 	return _managedObjectContextForMainThread;
@@ -257,6 +763,17 @@
 -(NSManagedObjectContext *)managedObjectContextForCurrentThreadWithError:(NSError **)error {
 	NSThread *thread = [NSThread currentThread];
 
+	// Set by performInBackground:completion: while a block is executed with a pooled context
+	NSManagedObjectContext *backgroundContext = [[thread threadDictionary] objectForKey:[self backgroundContextKey]];
+	if (backgroundContext) {
+		// A pooled context is in threadContexts, so batch requests made inside the block are queued for it as well
+		if ([backgroundContext isKindOfClass:[RHManagedObjectContext class]]) {
+			[self mergeQueuedStoreChangesIntoContext:(RHManagedObjectContext *)backgroundContext];
+		}
+
+		return backgroundContext;
+	}
+
 	if ([thread isMainThread]) {
 		return [self managedObjectContextForMainThreadWithError:error];
 	}
@@ -269,147 +786,1495 @@
 	if ( [[thread threadDictionary] objectForKey:threadKey] == nil ) {
 		// create a moc for this thread... NSPrivateQueueConcurrencyType doesn't work here due to legacy dependent code
         // NSPrivateQueueConcurrencyType expects everything to happen in the performBlock call, which is not the case with legacy code
+		CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
         RHManagedObjectContext *threadContext = [[RHManagedObjectContext alloc] initWithConcurrencyType:NSConfinementConcurrencyType];
-        [threadContext setPersistentStoreCoordinator:[self persistentStoreCoordinatorWithError:error]];
+
+        if (![self attachContext:threadContext error:error]) {
+			return nil;
+		}
+
 		[threadContext setMergePolicy:kMergePolicy];
 		[threadContext setObserver:self];
 
 		[[thread threadDictionary] setObject:threadContext forKey:threadKey];
+
+		@synchronized(self.threadContexts) {
+			[self.threadContexts addObject:threadContext];
+		}
+
+		if (self.instrumented) {
+			[self recordOperation:RHInstrumentationOperationContextCreation entityName:nil predicate:nil resultCount:0 startTime:startTime context:threadContext];
+		}
     }
 
-	return [[thread threadDictionary] objectForKey:threadKey];
+	RHManagedObjectContext *threadContext = [[thread threadDictionary] objectForKey:threadKey];
+
+	[self mergeQueuedStoreChangesIntoContext:threadContext];
+
+	return threadContext;
 }
 
-/**
- * Returns the managed object model for the application.
- * If the model doesn't already exist, it is created from the application's model.
- */
--(NSManagedObjectModel *)managedObjectModel {
-	if (_managedObjectModel == nil) {
-        NSString *modelPath = [self.bundle pathForResource:self.modelName ofType:@"momd"];
-		NSURL *modelURL = [NSURL fileURLWithPath:modelPath];
+-(void)applicationDidEnterBackground:(NSNotification *)notification {
+	if (!self.defersCommits && !self.writesAsynchronously) {
+		return;
+	}
+
+#if TARGET_OS_IPHONE
+	UIApplication *application = [UIApplication sharedApplication];
+	__block UIBackgroundTaskIdentifier backgroundTask = [application beginBackgroundTaskWithExpirationHandler:^{
+		[application endBackgroundTask:backgroundTask];
+		backgroundTask = UIBackgroundTaskInvalid;
+	}];
+
+	[self flush];
 
-		self.managedObjectModel = [[NSManagedObjectModel alloc] initWithContentsOfURL:modelURL];
+	if (backgroundTask != UIBackgroundTaskInvalid) {
+		[application endBackgroundTask:backgroundTask];
 	}
+#endif
+}
 
-	return _managedObjectModel;
+#pragma mark -
+#pragma mark Background contexts
+-(NSString *)backgroundContextKey {
+	return [NSString stringWithFormat:@"RHBackgroundManagedObjectContext_%@", self.modelName];
 }
 
--(void)mocDidSave:(NSNotification *)saveNotification {
-    if ([NSThread isMainThread]) {
-		// This ensures no updated object is fault, which would cause the NSFetchedResultsController updates to fail.
-		// http://www.mlsite.net/blog/?p=518
+-(void)setMaximumBackgroundContexts:(NSUInteger)maximumBackgroundContexts {
+	_maximumBackgroundContexts = MAX(maximumBackgroundContexts, 1);
+	[self.backgroundQueue setMaxConcurrentOperationCount:_maximumBackgroundContexts];
+}
 
-		NSDictionary *userInfo = saveNotification.userInfo;
+// The operation queue limits the number of blocks executed at once, so at most maximumBackgroundContexts are ever created
+-(RHManagedObjectContext *)dequeueBackgroundContextWithError:(NSError **)error {
+	@synchronized(self.idleBackgroundContexts) {
+		RHManagedObjectContext *moc = [self.idleBackgroundContexts lastObject];
 
-		NSSet *updates = [userInfo objectForKey:NSUpdatedObjectsKey];
-		for (RHManagedObject *item in updates) {
-			[[item objectInCurrentThreadContextWithError:nil] willAccessValueForKey:nil];
+		if (moc) {
+			[self.idleBackgroundContexts removeLastObject];
+			return moc;
 		}
 
-		// 2013-04-14 - This hack is also required on the "inserted" key to ensure NSFetchedResultsController works properly
-		NSSet *inserted = [userInfo objectForKey:NSInsertedObjectsKey];
-		for (RHManagedObject *item in inserted) {
-			[[item objectInCurrentThreadContextWithError:nil] willAccessValueForKey:nil];
+		self.backgroundContextCount++;
+	}
+
+	CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+	RHManagedObjectContext *moc = [[RHManagedObjectContext alloc] initWithConcurrencyType:NSPrivateQueueConcurrencyType];
+
+	if (![self attachContext:moc error:error]) {
+		@synchronized(self.idleBackgroundContexts) {
+			self.backgroundContextCount--;
 		}
+		return nil;
+	}
 
-        NSError *error = nil;
-        [[self managedObjectContextForMainThreadWithError:&error] mergeChangesFromContextDidSaveNotification:saveNotification];
+	[moc setMergePolicy:kMergePolicy];
+	[moc setObserver:self];
 
-    } else {
-        [self performSelectorOnMainThread:@selector(mocDidSave:) withObject:saveNotification waitUntilDone:NO];
-    }
-}
+	@synchronized(self.threadContexts) {
+		[self.threadContexts addObject:moc];
+	}
 
--(BOOL)doesRequireMigrationWithError:(NSError **)error {
-	if ([[NSFileManager defaultManager] fileExistsAtPath:[self storePath]]) {
-		//		NSError *error = nil;
-		NSDictionary *sourceMetadata = [NSPersistentStoreCoordinator
-                                        metadataForPersistentStoreOfType:NSSQLiteStoreType
-                                        URL:[self storeURL]
-                                        error:error];
-		return ![[self managedObjectModel] isConfiguration:nil
-                               compatibleWithStoreMetadata:sourceMetadata];
-	} else {
-		return NO;
+	if (self.instrumented) {
+		[self recordOperation:RHInstrumentationOperationContextCreation entityName:nil predicate:nil resultCount:0 startTime:startTime context:moc];
 	}
+
+	return moc;
 }
 
-/**
- * Returns the persistent store coordinator for the application.
- * If the coordinator doesn't already exist, it is created and the application's store added to it.
- */
--(NSPersistentStoreCoordinator *)persistentStoreCoordinatorWithError:(NSError **)error {
+-(void)performInBackground:(void (^)(NSManagedObjectContext *moc))block
+                completion:(void (^)(NSError *error))completion {
 
-	if (_persistentStoreCoordinator == nil) {
-		@synchronized(self) {
-			// This next block is useful when the store is initialized for the first time.  If the DB doesn't already
-			// exist and a copy of the db (with the same name) exists in the bundle, it'll be copied over and used.  This
-			// is useful for the initial seeding of data in the app.
-			NSString *storePath = [self storePath];
-			NSFileManager *fileManager = [NSFileManager defaultManager];
-
-			if (![fileManager fileExistsAtPath:storePath]) {
-				NSString *defaultStorePath = [[NSBundle mainBundle] pathForResource:[self databaseName] ofType:nil];
-
-				if ([fileManager fileExistsAtPath:defaultStorePath]) {
-					[fileManager copyItemAtPath:defaultStorePath toPath:storePath error:error];
+	NSDate *queuedDate = [NSDate date];
+	NSString *guid = self.guid;
+
+	[self.backgroundQueue addOperationWithBlock:^{
+		NSDate *startDate = [NSDate date];
+		__block NSError *error = nil;
+
+		RHManagedObjectContext *moc = [self dequeueBackgroundContextWithError:&error];
+
+		if (error == nil) {
+			[moc performBlockAndWait:^{
+				NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+				[threadDictionary setObject:moc forKey:[self backgroundContextKey]];
+
+				[self mergeQueuedStoreChangesIntoContext:moc];
+
+				@autoreleasepool {
+					block(moc);
+					error = [self commit];
+				}
+
+				[threadDictionary removeObjectForKey:[self backgroundContextKey]];
+				[moc reset];
+			}];
+
+			// Contexts of a deleted store are not reused
+			if ([guid isEqualToString:self.guid]) {
+				@synchronized(self.idleBackgroundContexts) {
+					[self.idleBackgroundContexts addObject:moc];
 				}
 			}
+		}
 
-			NSURL *storeURL = [self storeURL];
-			//			NSError *error = nil;
+		NSDate *endDate = [NSDate date];
 
-			self.persistentStoreCoordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:[self managedObjectModel]];
+		@synchronized(self.idleBackgroundContexts) {
+			self.backgroundTaskCount++;
+			self.backgroundWaitTime += [startDate timeIntervalSinceDate:queuedDate];
+			self.backgroundExecutionTime += [endDate timeIntervalSinceDate:startDate];
+		}
 
-			// https://developer.apple.com/library/mac/#documentation/Cocoa/Conceptual/CoreDataVersioning/Articles/vmLightweightMigration.html#//apple_ref/doc/uid/TP40004399-CH4-SW1
-			NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
-									 [NSNumber numberWithBool:YES], NSMigratePersistentStoresAutomaticallyOption,
-									 [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption, nil];
+		dispatch_async(dispatch_get_main_queue(), ^{
+			// The completion handler sees the changes of the block in the main thread managed object context
+			[self mergePendingChanges];
 
-			if (![_persistentStoreCoordinator addPersistentStoreWithType:NSSQLiteStoreType
-                                                          configuration:nil
-                                                                    URL:storeURL
-                                                                options:options
-                                                                  error:error]) {
-				/*
-				 Replace this implementation with code to handle the error appropriately.
+			if (completion) {
+				completion(error);
+			}
+		});
+	}];
+}
 
-				 abort() causes the application to generate a crash log and terminate. You should not use this function in a shipping application, although it may be useful during development. If it is not possible to recover from the error, display an alert panel that instructs the user to quit the application by pressing the Home button.
+-(BOOL)performWithTemporaryContext:(void (^)(NSManagedObjectContext *moc))block error:(NSError **)error {
+	CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
 
-				 Typical reasons for an error here include:
-				 * The persistent store is not accessible;
-				 * The schema for the persistent store is incompatible with current managed object model.
-				 Check the error message to determine what the actual problem was.
+	RHManagedObjectContext *moc = [[RHManagedObjectContext alloc] initWithConcurrencyType:NSConfinementConcurrencyType];
 
+	if (![self attachContext:moc error:error]) {
+		return NO;
+	}
 
-				 If the persistent store is not accessible, there is typically something wrong with the file path. Often, a file URL is pointing into the application's resources directory instead of a writeable directory.
+	[moc setMergePolicy:kMergePolicy];
+	[moc setObserver:self];
 
-				 If you encounter schema incompatibility errors during development, you can reduce their frequency by:
-				 * Simply deleting the existing store:
-				 [[NSFileManager defaultManager] removeItemAtURL:storeURL error:nil]
+	if (self.instrumented) {
+		[self recordOperation:RHInstrumentationOperationContextCreation entityName:nil predicate:nil resultCount:0 startTime:startTime context:moc];
+	}
 
-				 * Performing automatic lightweight migration by passing the following dictionary as the options parameter:
-				 [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:YES],NSMigratePersistentStoresAutomaticallyOption, [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption, nil];
+	// Installed like a pooled context, so the caller's managed object context and its pending changes are left alone
+	NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+	id previousContext = [threadDictionary objectForKey:[self backgroundContextKey]];
+	[threadDictionary setObject:moc forKey:[self backgroundContextKey]];
 
-				 Lightweight migration will only work for a limited set of schema changes; consult "Core Data Model Versioning and Data Migration Programming Guide" for details.
+	@autoreleasepool {
+		block(moc);
+	}
 
-				 */
-				NSLog(@"Unresolved error %@, %@", *error, [*error userInfo]);
-				abort();
-			}
-		} // end @synchronized
+	if (previousContext) {
+		[threadDictionary setObject:previousContext forKey:[self backgroundContextKey]];
+	} else {
+		[threadDictionary removeObjectForKey:[self backgroundContextKey]];
 	}
 
-	return _persistentStoreCoordinator;
+	[moc reset];
+
+	return YES;
+}
+
+-(NSDictionary *)backgroundStatistics {
+	@synchronized(self.idleBackgroundContexts) {
+		return [NSDictionary dictionaryWithObjectsAndKeys:
+				[NSNumber numberWithUnsignedInteger:self.backgroundTaskCount], RHBackgroundTaskCountKey,
+				[NSNumber numberWithUnsignedInteger:self.backgroundContextCount], RHBackgroundContextCountKey,
+				[NSNumber numberWithDouble:self.backgroundWaitTime], RHBackgroundWaitTimeKey,
+				[NSNumber numberWithDouble:self.backgroundExecutionTime], RHBackgroundExecutionTimeKey, nil];
+	}
+}
+
+/**
+ * Returns the managed object model for the application.
+ * If the model doesn't already exist, it is created from the application's model.
+ */
+-(NSManagedObjectModel *)managedObjectModel {
+	@synchronized(self) {
+		if (_managedObjectModel == nil) {
+			NSString *modelPath = [self.bundle pathForResource:self.modelName ofType:@"momd"];
+			NSURL *modelURL = [NSURL fileURLWithPath:modelPath];
+
+			self.managedObjectModel = [[NSManagedObjectModel alloc] initWithContentsOfURL:modelURL];
+		}
+
+		return _managedObjectModel;
+	}
+}
+
+-(NSEntityDescription *)entityForName:(NSString *)entityName {
+	return [[[self managedObjectModel] entitiesByName] objectForKey:entityName];
+}
+
+// Called on the thread of the saved context.  Only the object IDs are kept, the objects belong to the other thread.
+-(void)mocDidSave:(NSNotification *)saveNotification {
+	NSDictionary *userInfo = saveNotification.userInfo;
+	BOOL scheduleMerge = NO;
+
+	[self invalidateQueryCacheWithChanges:userInfo];
+	[self updateIdentityIndexesWithChanges:userInfo];
+
+	@synchronized(self.pendingSaveChanges) {
+		for (NSString *key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, nil]) {
+			NSMutableSet *objectIDs = [self.pendingSaveChanges objectForKey:key];
+
+			if (objectIDs == nil) {
+				objectIDs = [NSMutableSet set];
+				[self.pendingSaveChanges setObject:objectIDs forKey:key];
+			}
+
+			for (NSManagedObject *object in [userInfo objectForKey:key]) {
+				[objectIDs addObject:[object objectID]];
+			}
+		}
+
+		// A deleted object no longer needs to be inserted or updated
+		NSSet *deletedObjectIDs = [self.pendingSaveChanges objectForKey:NSDeletedObjectsKey];
+		[[self.pendingSaveChanges objectForKey:NSInsertedObjectsKey] minusSet:deletedObjectIDs];
+		[[self.pendingSaveChanges objectForKey:NSUpdatedObjectsKey] minusSet:deletedObjectIDs];
+
+		self.pendingSaveCount++;
+
+		if (!self.mergeScheduled) {
+			self.mergeScheduled = YES;
+			scheduleMerge = YES;
+		}
+	}
+
+	if (scheduleMerge) {
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.mergeCoalescingInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+			[self mergePendingChanges];
+		});
+	}
+}
+
+-(void)mergePendingChanges {
+	NSAssert([NSThread isMainThread], @"Must be called on main thread.");
+
+	NSDictionary *changes;
+	NSUInteger saveCount;
+
+	@synchronized(self.pendingSaveChanges) {
+		changes = [self.pendingSaveChanges copy];
+		saveCount = self.pendingSaveCount;
+
+		[self.pendingSaveChanges removeAllObjects];
+		self.pendingSaveCount = 0;
+		self.mergeScheduled = NO;
+	}
+
+	if (saveCount == 0) {
+		return;
+	}
+
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+	NSManagedObjectContext *moc = [self managedObjectContextForMainThreadWithError:nil];
+
+	// The saves are on disk, and a main thread context created once the stores are ready reads them from there
+	if (moc == nil) {
+		return;
+	}
+
+	NSSet *insertedObjectIDs = [changes objectForKey:NSInsertedObjectsKey];
+	NSSet *updatedObjectIDs = [changes objectForKey:NSUpdatedObjectsKey];
+	NSSet *deletedObjectIDs = [changes objectForKey:NSDeletedObjectsKey];
+
+	NSArray *fetchedResultsControllers;
+	@synchronized(self.fetchedResultsControllers) {
+		fetchedResultsControllers = [self.fetchedResultsControllers allObjects];
+	}
+
+	NSMutableArray *watchedEntities = [NSMutableArray array];
+	for (NSFetchedResultsController *controller in fetchedResultsControllers) {
+		if (([controller managedObjectContext] == moc) && [[controller fetchRequest] entity]) {
+			[watchedEntities addObject:[[controller fetchRequest] entity]];
+		}
+	}
+
+	// Updated and inserted objects must not be faults, otherwise the NSFetchedResultsController updates fail
+	// (http://www.mlsite.net/blog/?p=518).  This is only needed for objects the main thread may be showing: those that are
+	// already registered, and those of an entity that is watched by a fetched results controller.
+	NSMutableArray *faultObjectIDs = [NSMutableArray array];
+	NSMutableSet *updatedObjects = [NSMutableSet set];
+
+	for (NSManagedObjectID *objectID in [updatedObjectIDs setByAddingObjectsFromSet:insertedObjectIDs]) {
+		NSManagedObject *registeredObject = [moc objectRegisteredForID:objectID];
+		BOOL watched = NO;
+
+		for (NSEntityDescription *entity in watchedEntities) {
+			if ([[objectID entity] isKindOfEntity:entity]) {
+				watched = YES;
+				break;
+			}
+		}
+
+		if ((registeredObject && [registeredObject isFault]) || (!registeredObject && watched)) {
+			[faultObjectIDs addObject:objectID];
+		}
+
+		if ((registeredObject || watched) && [updatedObjectIDs containsObject:objectID]) {
+			[updatedObjects addObject:objectID];
+		}
+	}
+
+	[self faultInObjectIDs:faultObjectIDs context:moc];
+
+	NSMutableSet *mergedUpdatedObjects = [NSMutableSet setWithCapacity:[updatedObjects count]];
+	for (NSManagedObjectID *objectID in updatedObjects) {
+		[mergedUpdatedObjects addObject:[moc objectWithID:objectID]];
+	}
+
+	NSMutableSet *mergedInsertedObjects = [NSMutableSet setWithCapacity:[insertedObjectIDs count]];
+	for (NSManagedObjectID *objectID in insertedObjectIDs) {
+		[mergedInsertedObjects addObject:[moc objectWithID:objectID]];
+	}
+
+	NSMutableSet *mergedDeletedObjects = [NSMutableSet set];
+	for (NSManagedObjectID *objectID in deletedObjectIDs) {
+		NSManagedObject *registeredObject = [moc objectRegisteredForID:objectID];
+		if (registeredObject) {
+			[mergedDeletedObjects addObject:registeredObject];
+		}
+	}
+
+	NSDictionary *userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+							  mergedInsertedObjects, NSInsertedObjectsKey,
+							  mergedUpdatedObjects, NSUpdatedObjectsKey,
+							  mergedDeletedObjects, NSDeletedObjectsKey, nil];
+
+	[moc mergeChangesFromContextDidSaveNotification:[NSNotification notificationWithName:NSManagedObjectContextDidSaveNotification
+																				   object:nil
+																				 userInfo:userInfo]];
+
+	NSTimeInterval duration = CFAbsoluteTimeGetCurrent() - startTime;
+	NSUInteger objectCount = [insertedObjectIDs count] + [updatedObjectIDs count] + [deletedObjectIDs count];
+
+	if (self.instrumented) {
+		NSDictionary *changeCounts = [self changeCountsByEntityNameInSets:[NSArray arrayWithObjects:insertedObjectIDs, updatedObjectIDs, deletedObjectIDs, nil]];
+		[self recordOperation:RHInstrumentationOperationMerge changeCounts:changeCounts startTime:startTime context:moc];
+	}
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:RHDidMergeChangesNotification
+														object:self
+													  userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+																[NSNumber numberWithDouble:duration], RHMergeDurationKey,
+																[NSNumber numberWithUnsignedInteger:saveCount], RHMergeSaveCountKey,
+																[NSNumber numberWithUnsignedInteger:objectCount], RHMergeObjectCountKey, nil]];
+}
+
+// Loads objects with one fetch per entity instead of firing a fault per object
+-(void)faultInObjectIDs:(NSArray *)objectIDs context:(NSManagedObjectContext *)moc {
+	NSMutableDictionary *objectIDsByEntity = [NSMutableDictionary dictionary];
+
+	for (NSManagedObjectID *objectID in objectIDs) {
+		NSMutableArray *entityObjectIDs = [objectIDsByEntity objectForKey:[[objectID entity] name]];
+		if (entityObjectIDs == nil) {
+			entityObjectIDs = [NSMutableArray array];
+			[objectIDsByEntity setObject:entityObjectIDs forKey:[[objectID entity] name]];
+		}
+		[entityObjectIDs addObject:objectID];
+	}
+
+	for (NSString *entityName in objectIDsByEntity) {
+		NSArray *entityObjectIDs = [objectIDsByEntity objectForKey:entityName];
+
+		NSFetchRequest *fetch = [NSFetchRequest new];
+		[fetch setEntity:[[entityObjectIDs objectAtIndex:0] entity]];
+		[fetch setPredicate:[NSPredicate predicateWithFormat:@"self IN %@", entityObjectIDs]];
+		[fetch setReturnsObjectsAsFaults:NO];
+
+		[moc executeFetchRequest:fetch error:nil];
+	}
+}
+
++(void)registerFetchedResultsController:(NSFetchedResultsController *)controller {
+	Class entityClass = NSClassFromString([[[controller fetchRequest] entity] managedObjectClassName]);
+
+	if (![entityClass isSubclassOfClass:[RHManagedObject class]] || (entityClass == [RHManagedObject class])) {
+		return;
+	}
+
+	RHManagedObjectContextManager *manager = [entityClass managedObjectContextManager];
+
+	@synchronized(manager.fetchedResultsControllers) {
+		[manager.fetchedResultsControllers addObject:controller];
+	}
+}
+
+-(void)mergeStoreChanges:(NSDictionary *)changes {
+	NSThread *thread = [NSThread currentThread];
+	NSArray *threadContexts = nil;
+
+	[self invalidateQueryCacheWithChanges:changes];
+
+	[self updateIdentityIndexesWithStoreChanges:changes];
+
+	NSSet *entityNames = [self entityNamesWithChanges:changes];
+	for (RHMaterializedAggregate *aggregate in [self materializedAggregates]) {
+		if ([aggregate dependsOnEntityNames:entityNames]) {
+			[aggregate recomputeWithError:nil];
+		}
+	}
+
+	@synchronized(self.threadContexts) {
+		threadContexts = [self.threadContexts allObjects];
+	}
+
+	for (RHManagedObjectContext *threadContext in threadContexts) {
+		[threadContext enqueueStoreChanges:changes];
+	}
+
+	NSManagedObjectContext *writerContext = self.writerContext;
+	[writerContext performBlock:^{
+		[self mergeStoreChanges:changes intoContext:writerContext];
+	}];
+
+	// Only an existing main thread context has objects to refresh, so none is created (or waited for) here
+	if ([thread isMainThread]) {
+		[self mergeStoreChanges:changes intoContext:self.managedObjectContextForMainThread];
+	} else {
+		// Drains the queue of the context for this thread right away.
+		[self managedObjectContextForCurrentThreadWithError:nil];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self mergeStoreChanges:changes intoContext:self.managedObjectContextForMainThread];
+		});
+	}
+}
+
+-(void)persistentStoreDidChangeObjectsOfEntity:(NSEntityDescription *)entity {
+	NSMutableSet *entityNames = [NSMutableSet set];
+
+	for (; entity; entity = [entity superentity]) {
+		[entityNames addObject:[entity name]];
+	}
+
+	if (self.cachesQueries) {
+		[self.queryCache invalidateEntityNames:entityNames];
+	}
+
+	@synchronized(self.identityIndexes) {
+		for (NSString *entityName in entityNames) {
+			[[self.identityIndexes objectForKey:entityName] invalidate];
+		}
+	}
+
+	for (RHMaterializedAggregate *aggregate in [self materializedAggregates]) {
+		if ([aggregate dependsOnEntityNames:entityNames]) {
+			[aggregate recomputeWithError:nil];
+		}
+	}
+}
+
+-(NSPersistentStoreResult *)executeBatchRequest:(NSPersistentStoreRequest *)request error:(NSError **)error {
+	// Batch requests operate on the store, so asynchronously written changes must be on disk first
+	NSError *flushError = [self flush];
+	if (flushError) {
+		if (error) {
+			*error = flushError;
+		}
+		return nil;
+	}
+
+	NSEntityDescription *entity = nil;
+	NSString *changesKey = NSInsertedObjectsKey;
+
+	if ([request isKindOfClass:[NSBatchUpdateRequest class]]) {
+		entity = [(NSBatchUpdateRequest *)request entity];
+		changesKey = NSUpdatedObjectsKey;
+	} else if ([request respondsToSelector:@selector(entity)]) {
+		entity = [(id)request entity];
+	}
+
+	if (@available(iOS 9.0, macOS 10.11, *)) {
+		if ([request isKindOfClass:[NSBatchDeleteRequest class]]) {
+			entity = [[(NSBatchDeleteRequest *)request fetchRequest] entity];
+			changesKey = NSDeletedObjectsKey;
+		}
+	}
+
+	// Other stores (e.g., an in-memory cache) can't execute batch requests, and don't hold the entity anyway
+	if (entity && ([request affectedStores] == nil)) {
+		NSArray *stores = [self persistentStoresForEntity:entity error:error];
+
+		if (stores == nil) {
+			return nil;
+		}
+
+		[request setAffectedStores:stores];
+	}
+
+	NSManagedObjectContext *moc = [self managedObjectContextForCurrentThreadWithError:error];
+	NSPersistentStoreResult *result = [moc executeRequest:request error:error];
+
+	if (result == nil) {
+		return nil;
+	}
+
+	id changes = [(id)result result];
+
+	if ([changes isKindOfClass:[NSArray class]]) {
+		if ([changes count] > 0) {
+			[self mergeStoreChanges:[NSDictionary dictionaryWithObject:changes forKey:changesKey]];
+		}
+	} else {
+		[self persistentStoreDidChangeObjectsOfEntity:entity];
+	}
+
+	return result;
+}
+
+// Must be called on the thread (or queue) of the context
+-(void)mergeQueuedStoreChangesIntoContext:(RHManagedObjectContext *)moc {
+	BOOL needsRefresh = NO;
+	NSArray *queuedChanges = [moc dequeueStoreChanges:&needsRefresh];
+
+	if (needsRefresh) {
+		// Too many changes were queued to keep them, so every object is read from the store again.  Unsaved changes are
+		// kept, and a context without any is reset so it doesn't hold on to objects that may have been deleted.
+		if ([moc hasChanges]) {
+			NSTimeInterval stalenessInterval = [moc stalenessInterval];
+			[moc setStalenessInterval:0];
+
+			for (NSManagedObject *object in [[moc registeredObjects] allObjects]) {
+				[moc refreshObject:object mergeChanges:YES];
+			}
+
+			[moc setStalenessInterval:stalenessInterval];
+		} else {
+			[moc reset];
+		}
+		return;
+	}
+
+	for (NSDictionary *changes in queuedChanges) {
+		[self mergeStoreChanges:changes intoContext:moc];
+	}
+}
+
+-(void)mergeStoreChanges:(NSDictionary *)changes intoContext:(NSManagedObjectContext *)moc {
+	if (moc == nil) {
+		return;
+	}
+
+	CFAbsoluteTime startTime = self.instrumented ? CFAbsoluteTimeGetCurrent() : 0;
+
+	// Only objects already registered in the context need to be touched.  Deleted and inserted objects are merged through
+	// a synthesized save notification so the NSFetchedResultsController and didDelete machinery see them as usual.
+	NSMutableSet *deletedObjects = [NSMutableSet set];
+	for (NSManagedObjectID *objectID in [changes objectForKey:NSDeletedObjectsKey]) {
+		NSManagedObject *registeredObject = [moc objectRegisteredForID:objectID];
+		if (registeredObject) {
+			[deletedObjects addObject:registeredObject];
+		}
+	}
+
+	NSMutableSet *insertedObjects = [NSMutableSet set];
+	for (NSManagedObjectID *objectID in [changes objectForKey:NSInsertedObjectsKey]) {
+		[insertedObjects addObject:[moc objectWithID:objectID]];
+	}
+
+	if (([deletedObjects count] > 0) || ([insertedObjects count] > 0)) {
+		NSDictionary *userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+								  deletedObjects, NSDeletedObjectsKey,
+								  insertedObjects, NSInsertedObjectsKey, nil];
+
+		[moc mergeChangesFromContextDidSaveNotification:[NSNotification notificationWithName:NSManagedObjectContextDidSaveNotification
+																					   object:nil
+																					 userInfo:userInfo]];
+	}
+
+	// Batch updates bypass the coordinator's row cache, so refresh with a zero staleness interval to read the new values.
+	NSTimeInterval stalenessInterval = [moc stalenessInterval];
+	[moc setStalenessInterval:0];
+
+	for (NSManagedObjectID *objectID in [changes objectForKey:NSUpdatedObjectsKey]) {
+		NSManagedObject *registeredObject = [moc objectRegisteredForID:objectID];
+		if (registeredObject) {
+			[moc refreshObject:registeredObject mergeChanges:YES];
+			[registeredObject willAccessValueForKey:nil];
+		}
+	}
+
+	[moc setStalenessInterval:stalenessInterval];
+
+	if (self.instrumented) {
+		NSMutableArray *sets = [NSMutableArray arrayWithCapacity:3];
+		for (NSString *key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, nil]) {
+			if ([changes objectForKey:key]) {
+				[sets addObject:[changes objectForKey:key]];
+			}
+		}
+
+		[self recordOperation:RHInstrumentationOperationMerge changeCounts:[self changeCountsByEntityNameInSets:sets] startTime:startTime context:moc];
+	}
+}
+
+#pragma mark -
+#pragma mark Query cache
+-(void)setCachesQueries:(BOOL)cachesQueries {
+	_cachesQueries = cachesQueries;
+
+	if (!cachesQueries) {
+		[self.queryCache removeAllObjects];
+	}
+}
+
+-(void)invalidateQueryCacheWithChanges:(NSDictionary *)changes {
+	if (!self.cachesQueries || (changes == nil)) {
+		return;
+	}
+
+	if ([changes objectForKey:NSInvalidatedAllObjectsKey]) {
+		[self.queryCache removeAllObjects];
+		return;
+	}
+
+	NSSet *entityNames = [self entityNamesWithChanges:changes];
+
+	if ([entityNames count] > 0) {
+		[self.queryCache invalidateEntityNames:entityNames];
+	}
+}
+
+// A result of a superentity includes the objects of its subentities
+-(NSSet *)entityNamesWithChanges:(NSDictionary *)changes {
+	NSMutableSet *entityNames = [NSMutableSet set];
+
+	for (NSString *key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, NSInvalidatedObjectsKey, nil]) {
+		for (id object in [changes objectForKey:key]) {
+			for (NSEntityDescription *entity = [object entity]; entity; entity = [entity superentity]) {
+				[entityNames addObject:[entity name]];
+			}
+		}
+	}
+
+	return entityNames;
+}
+
+#pragma mark -
+#pragma mark Materialized aggregates
+-(void)registerMaterializedAggregate:(RHMaterializedAggregate *)aggregate {
+	@synchronized(self.materializedAggregateList) {
+		if (![self.materializedAggregateList containsObject:aggregate]) {
+			[self.materializedAggregateList addObject:aggregate];
+		}
+	}
+}
+
+-(void)unregisterMaterializedAggregate:(RHMaterializedAggregate *)aggregate {
+	@synchronized(self.materializedAggregateList) {
+		[self.materializedAggregateList removeObject:aggregate];
+	}
+}
+
+-(NSArray *)materializedAggregates {
+	@synchronized(self.materializedAggregateList) {
+		return [self.materializedAggregateList copy];
+	}
+}
+
+#pragma mark -
+#pragma mark Identity indexes
+-(RHIdentityIndex *)identityIndexForEntity:(NSEntityDescription *)entity key:(NSString *)key {
+	@synchronized(self.identityIndexes) {
+		RHIdentityIndex *index = [self.identityIndexes objectForKey:[entity name]];
+
+		if (index == nil) {
+			index = [[RHIdentityIndex alloc] initWithEntity:entity key:key];
+			[self.identityIndexes setObject:index forKey:[entity name]];
+		}
+
+		return index;
+	}
+}
+
+// The index of a superentity also holds the objects of its subentities
+-(void)updateIdentityIndexesWithChanges:(NSDictionary *)changes {
+	NSDictionary *identityIndexes = nil;
+
+	@synchronized(self.identityIndexes) {
+		if ([self.identityIndexes count] == 0) {
+			return;
+		}
+
+		identityIndexes = [self.identityIndexes copy];
+	}
+
+	for (NSString *key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, nil]) {
+		BOOL deleted = [key isEqualToString:NSDeletedObjectsKey];
+
+		for (NSManagedObject *object in [changes objectForKey:key]) {
+			for (NSEntityDescription *entity = [object entity]; entity; entity = [entity superentity]) {
+				RHIdentityIndex *index = [identityIndexes objectForKey:[entity name]];
+
+				if (index == nil) {
+					continue;
+				}
+
+				if (deleted) {
+					[index removeObjectID:[object objectID]];
+				} else {
+					[index setObjectID:[object objectID] forKey:[object valueForKey:index.key]];
+				}
+			}
+		}
+	}
+}
+
+// Only the object IDs are known, so indexes with inserted or updated objects are loaded again
+-(void)updateIdentityIndexesWithStoreChanges:(NSDictionary *)changes {
+	NSDictionary *identityIndexes = nil;
+
+	@synchronized(self.identityIndexes) {
+		if ([self.identityIndexes count] == 0) {
+			return;
+		}
+
+		identityIndexes = [self.identityIndexes copy];
+	}
+
+	for (NSString *key in [NSArray arrayWithObjects:NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey, nil]) {
+		BOOL deleted = [key isEqualToString:NSDeletedObjectsKey];
+
+		for (NSManagedObjectID *objectID in [changes objectForKey:key]) {
+			for (NSEntityDescription *entity = [objectID entity]; entity; entity = [entity superentity]) {
+				RHIdentityIndex *index = [identityIndexes objectForKey:[entity name]];
+
+				if (deleted) {
+					[index removeObjectID:objectID];
+				} else {
+					[index invalidate];
+				}
+			}
+		}
+	}
+}
+
+#pragma mark -
+#pragma mark Instrumentation
+-(void)setInstrumentationBlock:(RHInstrumentationBlock)instrumentationBlock {
+	@synchronized(self.histograms) {
+		_instrumentationBlock = [instrumentationBlock copy];
+	}
+	[self updateInstrumented];
+}
+
+-(RHInstrumentationBlock)instrumentationBlock {
+	@synchronized(self.histograms) {
+		return _instrumentationBlock;
+	}
+}
+
+-(void)setCollectsHistograms:(BOOL)collectsHistograms {
+	_collectsHistograms = collectsHistograms;
+	[self updateInstrumented];
+}
+
+// Read without a lock on every operation, so it is a plain flag rather than a check of the block
+-(void)updateInstrumented {
+	self.instrumented = self.collectsHistograms || (self.instrumentationBlock != nil);
+}
+
+-(void)recordOperation:(RHInstrumentationOperation)operation
+            entityName:(NSString *)entityName
+             predicate:(NSPredicate *)predicate
+           resultCount:(NSUInteger)resultCount
+             startTime:(CFAbsoluteTime)startTime
+               context:(NSManagedObjectContext *)moc {
+
+	if (!self.instrumented) {
+		return;
+	}
+
+	NSTimeInterval duration = CFAbsoluteTimeGetCurrent() - startTime;
+
+	if (self.collectsHistograms) {
+		id entityKey = entityName ? entityName : (id)[NSNull null];
+		NSString *operationName = [RHInstrumentationEvent nameOfOperation:operation];
+
+		@synchronized(self.histograms) {
+			NSMutableDictionary *entityHistograms = [self.histograms objectForKey:entityKey];
+			if (entityHistograms == nil) {
+				entityHistograms = [NSMutableDictionary dictionary];
+				[self.histograms setObject:entityHistograms forKey:entityKey];
+			}
+
+			RHInstrumentationHistogram *histogram = [entityHistograms objectForKey:operationName];
+			if (histogram == nil) {
+				histogram = [[RHInstrumentationHistogram alloc] initWithWindow:kHistogramWindow];
+				[entityHistograms setObject:histogram forKey:operationName];
+			}
+
+			[histogram recordDuration:duration resultCount:resultCount];
+		}
+	}
+
+	RHInstrumentationBlock instrumentationBlock = self.instrumentationBlock;
+
+	if (instrumentationBlock) {
+		NSThread *thread = [NSThread currentThread];
+
+		RHInstrumentationEvent *event = [RHInstrumentationEvent new];
+		event.operation = operation;
+		event.entityName = entityName;
+		event.predicateFormat = [predicate predicateFormat];
+		event.resultCount = resultCount;
+		event.duration = duration;
+		event.threadName = [thread name];
+		event.mainThread = [thread isMainThread];
+		event.managedObjectContext = moc;
+
+		instrumentationBlock(event);
+	}
+}
+
+// Commits and merges are recorded once for each entity with changes, with the duration of the whole operation
+-(void)recordOperation:(RHInstrumentationOperation)operation
+          changeCounts:(NSDictionary *)changeCounts
+             startTime:(CFAbsoluteTime)startTime
+               context:(NSManagedObjectContext *)moc {
+
+	for (NSString *entityName in changeCounts) {
+		[self recordOperation:operation entityName:entityName predicate:nil resultCount:[[changeCounts objectForKey:entityName] unsignedIntegerValue] startTime:startTime context:moc];
+	}
+}
+
+// Counts managed objects or object IDs by the name of their entity
+-(NSDictionary *)changeCountsByEntityNameInSets:(NSArray *)sets {
+	NSCountedSet *entityNames = [NSCountedSet set];
+
+	for (id<NSFastEnumeration> objects in sets) {
+		for (id object in objects) {
+			[entityNames addObject:[[object entity] name]];
+		}
+	}
+
+	NSMutableDictionary *changeCounts = [NSMutableDictionary dictionaryWithCapacity:[entityNames count]];
+	for (NSString *entityName in entityNames) {
+		[changeCounts setObject:[NSNumber numberWithUnsignedInteger:[entityNames countForObject:entityName]] forKey:entityName];
+	}
+
+	return changeCounts;
+}
+
+-(NSDictionary *)histogramsForEntityName:(NSString *)entityName {
+	id entityKey = entityName ? entityName : (id)[NSNull null];
+	NSMutableDictionary *histograms = [NSMutableDictionary dictionary];
+
+	@synchronized(self.histograms) {
+		NSDictionary *entityHistograms = [self.histograms objectForKey:entityKey];
+
+		for (NSString *operationName in entityHistograms) {
+			[histograms setObject:[[entityHistograms objectForKey:operationName] copy] forKey:operationName];
+		}
+	}
+
+	return histograms;
+}
+
+-(void)resetHistograms {
+	@synchronized(self.histograms) {
+		[self.histograms removeAllObjects];
+	}
+}
+
+// Returns the stores added with a model configuration that contains the entity
+-(NSArray *)persistentStoresForEntity:(NSEntityDescription *)entity error:(NSError **)error {
+	NSPersistentStoreCoordinator *coordinator = [self persistentStoreCoordinatorWithError:error];
+
+	if (coordinator == nil) {
+		return nil;
+	}
+
+	NSManagedObjectModel *model = [coordinator managedObjectModel];
+	NSMutableArray *stores = [NSMutableArray array];
+
+	for (NSPersistentStore *store in [coordinator persistentStores]) {
+		// The default configuration contains every entity
+		NSArray *entities = [model entitiesForConfiguration:[store configurationName]];
+
+		if ((entities == nil) || [[entities valueForKey:@"name"] containsObject:[entity name]]) {
+			[stores addObject:store];
+		}
+	}
+
+	return stores;
+}
+
+-(BOOL)supportsBatchRequestsForEntity:(NSEntityDescription *)entity error:(NSError **)error {
+	NSArray *stores = [self persistentStoresForEntity:entity error:error];
+
+	if ([stores count] == 0) {
+		return NO;
+	}
+
+	for (NSPersistentStore *store in stores) {
+		if (![[store type] isEqualToString:NSSQLiteStoreType]) {
+			return NO;
+		}
+	}
+
+	return YES;
+}
+
+-(BOOL)doesRequireMigrationWithError:(NSError **)error {
+	if ([[self mainStoreConfiguration] isSQLiteStore] && [[NSFileManager defaultManager] fileExistsAtPath:[self storePath]]) {
+		//		NSError *error = nil;
+		NSDictionary *sourceMetadata = [NSPersistentStoreCoordinator
+                                        metadataForPersistentStoreOfType:NSSQLiteStoreType
+                                        URL:[self storeURL]
+                                        error:error];
+		return ![[self managedObjectModel] isConfiguration:nil
+                               compatibleWithStoreMetadata:sourceMetadata];
+	} else {
+		return NO;
+	}
+}
+
+-(NSArray *)modelVersions {
+	NSString *modelDirectory = [self.modelName stringByAppendingPathExtension:@"momd"];
+	NSArray *modelURLs = [[self.bundle URLsForResourcesWithExtension:@"mom" subdirectory:modelDirectory]
+						  sortedArrayUsingComparator:^NSComparisonResult(NSURL *url1, NSURL *url2) {
+							  // Natural order, so "Model10" follows "Model9"
+							  return [[url1 lastPathComponent] localizedStandardCompare:[url2 lastPathComponent]];
+						  }];
+
+	NSMutableArray *modelVersions = [NSMutableArray arrayWithCapacity:[modelURLs count]];
+
+	for (NSURL *modelURL in modelURLs) {
+		NSManagedObjectModel *model = [[NSManagedObjectModel alloc] initWithContentsOfURL:modelURL];
+		if (model) {
+			[modelVersions addObject:model];
+		}
+	}
+
+	return modelVersions;
+}
+
+-(BOOL)migrateStoreWithProgress:(RHMigrationProgressBlock)progress error:(NSError **)error {
+	RHStoreConfiguration *configuration = [self mainStoreConfiguration];
+	NSURL *storeURL = [self storeURLForConfiguration:configuration];
+
+	if (![configuration isSQLiteStore] || ![[NSFileManager defaultManager] fileExistsAtPath:[storeURL path]]) {
+		return YES;
+	}
+
+	NSDictionary *metadata = [NSPersistentStoreCoordinator metadataForPersistentStoreOfType:NSSQLiteStoreType URL:storeURL error:error];
+
+	if (metadata == nil) {
+		return NO;
+	}
+
+	NSManagedObjectModel *destinationModel = [self managedObjectModel];
+
+	if ([destinationModel isConfiguration:nil compatibleWithStoreMetadata:metadata]) {
+		return YES;
+	}
+
+	NSArray *modelVersions = [self modelVersions];
+
+	// A model that is not versioned (e.g., constructed programmatically) is left to the automatic lightweight migration
+	if ([modelVersions count] == 0) {
+		return YES;
+	}
+
+	NSUInteger sourceIndex = NSNotFound;
+	NSUInteger destinationIndex = NSNotFound;
+
+	for (NSUInteger i = 0; i < [modelVersions count]; i++) {
+		NSManagedObjectModel *model = [modelVersions objectAtIndex:i];
+
+		if ([model isConfiguration:nil compatibleWithStoreMetadata:metadata]) {
+			sourceIndex = i;
+		}
+
+		if ([[model entityVersionHashesByName] isEqualToDictionary:[destinationModel entityVersionHashesByName]]) {
+			destinationIndex = i;
+		}
+	}
+
+	if (sourceIndex == NSNotFound) {
+		if (error) {
+			*error = [self migrationErrorWithDescription:@"The store does not match any version of the data model."];
+		}
+		return NO;
+	}
+
+	NSMutableArray *steps;
+
+	if (destinationIndex == NSNotFound) {
+		steps = [NSMutableArray arrayWithArray:[modelVersions subarrayWithRange:NSMakeRange(sourceIndex, [modelVersions count] - sourceIndex)]];
+		[steps addObject:destinationModel];
+	} else if (destinationIndex > sourceIndex) {
+		steps = [NSMutableArray arrayWithArray:[modelVersions subarrayWithRange:NSMakeRange(sourceIndex, destinationIndex - sourceIndex + 1)]];
+	} else {
+		if (error) {
+			*error = [self migrationErrorWithDescription:@"The store was created by a later version of the data model."];
+		}
+		return NO;
+	}
+
+	NSUInteger stepCount = [steps count] - 1;
+
+	for (NSUInteger i = 0; i < stepCount; i++) {
+		BOOL migrated;
+
+		@autoreleasepool {
+			migrated = [self migrateStoreAtURL:storeURL
+									 fromModel:[steps objectAtIndex:i]
+									   toModel:[steps objectAtIndex:i + 1]
+									  progress:^(float stepProgress) {
+										  if (progress) {
+											  dispatch_async(dispatch_get_main_queue(), ^{
+												  progress((i + stepProgress) / stepCount);
+											  });
+										  }
+									  }
+										 error:error];
+		}
+
+		if (!migrated) {
+			return NO;
+		}
+	}
+
+	return YES;
+}
+
+-(BOOL)migrateStoreAtURL:(NSURL *)storeURL fromModel:(NSManagedObjectModel *)sourceModel toModel:(NSManagedObjectModel *)destinationModel progress:(RHMigrationProgressBlock)progress error:(NSError **)error {
+	NSMappingModel *mappingModel = [NSMappingModel mappingModelFromBundles:[NSArray arrayWithObject:self.bundle]
+															forSourceModel:sourceModel
+														  destinationModel:destinationModel];
+
+	// Without a mapping model the step is lightweight, which SQLite performs in place without loading any objects
+	if (mappingModel == nil) {
+		NSPersistentStoreCoordinator *coordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:destinationModel];
+		NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
+								 [NSNumber numberWithBool:YES], NSMigratePersistentStoresAutomaticallyOption,
+								 [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption, nil];
+
+		NSPersistentStore *store = [coordinator addPersistentStoreWithType:NSSQLiteStoreType configuration:nil URL:storeURL options:options error:error];
+
+		if (store == nil) {
+			return NO;
+		}
+
+		[coordinator removePersistentStore:store error:nil];
+		progress(1);
+
+		return YES;
+	}
+
+	// A custom mapping migrates into a new file, which replaces the store once it is complete
+	NSURL *destinationURL = [NSURL fileURLWithPath:[[storeURL path] stringByAppendingString:@".migration"]];
+	[self deleteStoreFiles:[destinationURL path]];
+
+	// A rollback journal leaves a single file to move into place
+	NSDictionary *destinationOptions = [NSDictionary dictionaryWithObject:[NSDictionary dictionaryWithObject:@"DELETE" forKey:@"journal_mode"]
+																   forKey:NSSQLitePragmasOption];
+
+	// Each pass migrates into the same file with a new migration manager, so only the objects of one pass are in memory at once
+	NSArray *passes = [self mappingModelPassesForMappingModel:mappingModel sourceModel:sourceModel destinationModel:destinationModel];
+	NSUInteger passCount = [passes count];
+
+	for (NSUInteger pass = 0; pass < passCount; pass++) {
+		BOOL migrated;
+
+		@autoreleasepool {
+			NSMigrationManager *migrationManager = [[NSMigrationManager alloc] initWithSourceModel:sourceModel destinationModel:destinationModel];
+			RHMigrationProgressObserver *observer = [[RHMigrationProgressObserver alloc] init];
+			observer.progressBlock = ^(float passProgress) {
+				progress((pass + passProgress) / passCount);
+			};
+
+			[migrationManager addObserver:observer forKeyPath:@"migrationProgress" options:0 context:NULL];
+
+			migrated = [migrationManager migrateStoreFromURL:storeURL
+														type:NSSQLiteStoreType
+													 options:nil
+											withMappingModel:[passes objectAtIndex:pass]
+											toDestinationURL:destinationURL
+											 destinationType:NSSQLiteStoreType
+										  destinationOptions:destinationOptions
+													   error:error];
+
+			[migrationManager removeObserver:observer forKeyPath:@"migrationProgress"];
+		}
+
+		if (!migrated) {
+			[self deleteStoreFiles:[destinationURL path]];
+			return NO;
+		}
+	}
+
+	// The original is kept as a backup until the migrated file is in place, and restored if either move fails
+	NSString *backupPath = [[storeURL path] stringByAppendingString:@".backup"];
+	[self deleteStoreFiles:backupPath];
+
+	NSError *fileError = [self moveStoreFiles:[storeURL path] toPath:backupPath];
+
+	if (fileError == nil) {
+		fileError = [self moveStoreFiles:[destinationURL path] toPath:[storeURL path]];
+	}
+
+	if (fileError) {
+		[self moveStoreFiles:backupPath toPath:[storeURL path]];
+		[self deleteStoreFiles:[destinationURL path]];
+
+		if (error) {
+			*error = fileError;
+		}
+		return NO;
+	}
+
+	[self deleteStoreFiles:backupPath];
+
+	return YES;
+}
+
+// Splits a mapping model into one mapping model per entity mapping, for one migration pass each.  Relationships are only resolved between objects migrated
+// by the same migration manager, so entity mappings of related entities (or of entities in the same inheritance hierarchy)
+// stay in the same pass.
+-(NSArray *)mappingModelPassesForMappingModel:(NSMappingModel *)mappingModel sourceModel:(NSManagedObjectModel *)sourceModel destinationModel:(NSManagedObjectModel *)destinationModel {
+	NSMutableArray *groupEntityNames = [NSMutableArray array];
+	NSMutableArray *groupMappings = [NSMutableArray array];
+
+	for (NSEntityMapping *entityMapping in [mappingModel entityMappings]) {
+		NSMutableSet *entityNames = [NSMutableSet set];
+		NSMutableArray *mappings = [NSMutableArray arrayWithObject:entityMapping];
+
+		// Added entities have no source entity, removed entities no destination entity
+		NSMutableArray *entities = [NSMutableArray arrayWithCapacity:2];
+
+		if ([entityMapping sourceEntityName] && [[sourceModel entitiesByName] objectForKey:[entityMapping sourceEntityName]]) {
+			[entities addObject:[[sourceModel entitiesByName] objectForKey:[entityMapping sourceEntityName]]];
+		}
+
+		if ([entityMapping destinationEntityName] && [[destinationModel entitiesByName] objectForKey:[entityMapping destinationEntityName]]) {
+			[entities addObject:[[destinationModel entitiesByName] objectForKey:[entityMapping destinationEntityName]]];
+		}
+
+		for (NSEntityDescription *entity in entities) {
+			[entityNames addObject:[entity name]];
+
+			for (NSEntityDescription *superentity = [entity superentity]; superentity; superentity = [superentity superentity]) {
+				[entityNames addObject:[superentity name]];
+			}
+
+			for (NSEntityDescription *subentity in [entity subentities]) {
+				[entityNames addObject:[subentity name]];
+			}
+
+			for (NSRelationshipDescription *relationship in [[entity relationshipsByName] allValues]) {
+				if ([relationship destinationEntity]) {
+					[entityNames addObject:[[relationship destinationEntity] name]];
+				}
+			}
+		}
+
+		// Merge every earlier group that shares an entity with this mapping
+		for (NSInteger i = [groupEntityNames count] - 1; i >= 0; i--) {
+			if ([[groupEntityNames objectAtIndex:i] intersectsSet:entityNames]) {
+				[entityNames unionSet:[groupEntityNames objectAtIndex:i]];
+				[mappings insertObjects:[groupMappings objectAtIndex:i] atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [[groupMappings objectAtIndex:i] count])]];
+				[groupEntityNames removeObjectAtIndex:i];
+				[groupMappings removeObjectAtIndex:i];
+			}
+		}
+
+		[groupEntityNames addObject:entityNames];
+		[groupMappings addObject:mappings];
+	}
+
+	if ([groupMappings count] <= 1) {
+		return [NSArray arrayWithObject:mappingModel];
+	}
+
+	NSMutableArray *passes = [NSMutableArray arrayWithCapacity:[groupMappings count]];
+
+	for (NSArray *mappings in groupMappings) {
+		NSMappingModel *pass = [[NSMappingModel alloc] init];
+		[pass setEntityMappings:mappings];
+		[passes addObject:pass];
+	}
+
+	return passes;
+}
+
+// Moves the store file and its -shm and -wal files, replacing the files at the destination
+-(NSError *)moveStoreFiles:(NSString *)storePath toPath:(NSString *)destinationPath {
+	NSFileManager *fm = [NSFileManager defaultManager];
+	NSError *error = nil;
+
+	for (NSString *suffix in [NSArray arrayWithObjects:@"", @"-shm", @"-wal", nil]) {
+		NSString *sourceFile = [storePath stringByAppendingString:suffix];
+		NSString *destinationFile = [destinationPath stringByAppendingString:suffix];
+
+		if (![fm fileExistsAtPath:sourceFile]) {
+			continue;
+		}
+
+		NSError *fileError = [RHManagedObjectContextManager deleteFile:destinationFile];
+
+		if (fileError == nil) {
+			[fm moveItemAtPath:sourceFile toPath:destinationFile error:&fileError];
+		}
+
+		if (fileError && (error == nil)) {
+			error = fileError;
+		}
+	}
+
+	return error;
+}
+
+-(NSError *)migrationErrorWithDescription:(NSString *)description {
+	return [NSError errorWithDomain:RHManagedObjectErrorDomain
+							   code:RHManagedObjectErrorMigrationFailed
+						   userInfo:[NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey]];
+}
+
+/**
+ * Returns the persistent store coordinator for the application.
+ * If the coordinator doesn't already exist, it is created and the application's store added to it.
+ */
+-(NSPersistentStoreCoordinator *)persistentStoreCoordinatorWithError:(NSError **)error {
+	if (_persistentStoreCoordinator) {
+		return _persistentStoreCoordinator;
+	}
+
+	// Waiting on the main thread would block the launch that loadStoresWithCompletion: is meant to keep responsive
+	NSTimeInterval timeout = [NSThread isMainThread] ? self.mainThreadStoreLoadingTimeout : self.storeLoadingTimeout;
+
+	return [self persistentStoreCoordinatorWaitingUntilDate:[NSDate dateWithTimeIntervalSinceNow:timeout] retry:NO progress:nil error:error];
+}
+
+// Only one thread loads the stores.  Other threads wait on the condition until it finished or the deadline passed, rather
+// than on a lock they can't give up on.
+-(NSPersistentStoreCoordinator *)persistentStoreCoordinatorWaitingUntilDate:(NSDate *)deadline retry:(BOOL)retry progress:(RHMigrationProgressBlock)progress error:(NSError **)error {
+	NSCondition *condition = self.storeLoadingCondition;
+	NSError *loadingError = nil;
+
+	[condition lock];
+
+	while ((self.storeLoadingState == RHStoreLoadingStateLoading) && [condition waitUntilDate:deadline]);
+
+	if (self.storeLoadingState == RHStoreLoadingStateLoading) {
+		[condition unlock];
+
+		if (error) {
+			*error = [NSError errorWithDomain:RHManagedObjectErrorDomain
+										 code:RHManagedObjectErrorStoreNotReady
+									 userInfo:[NSDictionary dictionaryWithObject:@"The persistent stores are still being loaded." forKey:NSLocalizedDescriptionKey]];
+		}
+		return nil;
+	}
+
+	if ((self.storeLoadingState == RHStoreLoadingStateNotLoaded) || (retry && (self.storeLoadingState == RHStoreLoadingStateFailed))) {
+		self.storeLoadingState = RHStoreLoadingStateLoading;
+		[condition unlock];
+
+		NSPersistentStoreCoordinator *coordinator = [self newPersistentStoreCoordinatorWithProgress:progress error:&loadingError];
+
+		[condition lock];
+		self.persistentStoreCoordinator = coordinator;
+		self.storeLoadingError = loadingError;
+		self.storeLoadingState = coordinator ? RHStoreLoadingStateLoaded : RHStoreLoadingStateFailed;
+		[condition broadcast];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[[NSNotificationCenter defaultCenter] postNotificationName:RHStoresDidLoadNotification
+																object:self
+															  userInfo:loadingError ? [NSDictionary dictionaryWithObject:loadingError forKey:RHStoreLoadingErrorKey] : nil];
+		});
+	}
+
+	NSPersistentStoreCoordinator *coordinator = _persistentStoreCoordinator;
+
+	if ((coordinator == nil) && error) {
+		*error = self.storeLoadingError;
+	}
+
+	[condition unlock];
+
+	return coordinator;
+}
+
+-(void)loadStoresWithCompletion:(void (^)(NSError *error))completion {
+	[self loadStoresWithProgress:nil completion:completion];
+}
+
+-(void)loadStoresWithProgress:(RHMigrationProgressBlock)progress completion:(void (^)(NSError *error))completion {
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSError *error = nil;
+		[self persistentStoreCoordinatorWaitingUntilDate:[NSDate distantFuture] retry:YES progress:progress error:&error];
+
+		if (completion) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completion(error);
+			});
+		}
+	});
+}
+
+-(NSPersistentStoreCoordinator *)newPersistentStoreCoordinatorWithProgress:(RHMigrationProgressBlock)progress error:(NSError **)error {
+	// This next block is useful when the store is initialized for the first time.  If the DB doesn't already
+	// exist and a copy of the db (with the same name) exists in the bundle, it'll be copied over and used.  This
+	// is useful for the initial seeding of data in the app.
+	NSString *storePath = [self storePath];
+	NSFileManager *fileManager = [NSFileManager defaultManager];
+
+	if ([[self mainStoreConfiguration] isSQLiteStore] && ![fileManager fileExistsAtPath:storePath]) {
+		NSString *defaultStorePath = [[NSBundle mainBundle] pathForResource:[self databaseName] ofType:nil];
+
+		// A failed copy only means the store starts empty, so its error is not reported as the loading error
+		NSError *copyError = nil;
+		if ([fileManager fileExistsAtPath:defaultStorePath] && ![fileManager copyItemAtPath:defaultStorePath toPath:storePath error:&copyError]) {
+			NSLog(@"Could not copy the seed database %@, %@", copyError, [copyError userInfo]);
+		}
+	}
+
+	NSError *loadError = nil;
+
+	if (![self migrateStoreWithProgress:progress error:&loadError]) {
+		NSLog(@"Unresolved error %@, %@", loadError, [loadError userInfo]);
+		if (error) {
+			*error = loadError;
+		}
+		return nil;
+	}
+
+	// Entities are assigned to the configurations before the model is used by the coordinator, after which it can't be changed.
+	// This is the model entities were already handed out from, so it must not be replaced by a copy.
+	NSManagedObjectModel *model = [self managedObjectModel];
+	NSMutableArray *configurationNames = [NSMutableArray arrayWithCapacity:[self.storeConfigurations count]];
+
+	for (RHStoreConfiguration *configuration in self.storeConfigurations) {
+		NSString *configurationName = [self configurationNameForStore:configuration model:model];
+		[configurationNames addObject:configurationName ? configurationName : (id)[NSNull null]];
+	}
+
+	NSPersistentStoreCoordinator *coordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:model];
+
+	for (NSUInteger i = 0; i < [self.storeConfigurations count]; i++) {
+		RHStoreConfiguration *configuration = [self.storeConfigurations objectAtIndex:i];
+		id configurationName = [configurationNames objectAtIndex:i];
+
+		// Typical reasons for an error here are a store that is not accessible, or a schema that is incompatible with
+		// the current model and can't be migrated automatically.  The error is returned to every caller rather than
+		// terminating the application, so it can be handled, e.g., by deleting the store.
+		if (![coordinator addPersistentStoreWithType:configuration.storeType
+		                               configuration:[configurationName isKindOfClass:[NSString class]] ? configurationName : nil
+		                                         URL:[self storeURLForConfiguration:configuration]
+		                                     options:[configuration storeOptions]
+		                                       error:&loadError]) {
+			NSLog(@"Unresolved error %@, %@", loadError, [loadError userInfo]);
+			if (error) {
+				*error = loadError;
+			}
+			return nil;
+		}
+	}
+
+	return coordinator;
 }
 
 #pragma mark -
 #pragma mark Application's Documents directory
 -(NSString *)storePath {
+	RHStoreConfiguration *configuration = [self mainStoreConfiguration];
+
+	if (configuration.storeURL) {
+		return [configuration.storeURL path];
+	}
+
 	return [[self applicationDocumentsDirectory] stringByAppendingPathComponent:[self databaseName]];
 }
 
+-(NSURL *)storeURLForConfiguration:(RHStoreConfiguration *)configuration {
+	if (![configuration isSQLiteStore]) {
+		return nil;
+	}
+
+	if (configuration.storeURL) {
+		return configuration.storeURL;
+	}
+
+	if ((configuration == [self mainStoreConfiguration]) || (configuration.configurationName == nil)) {
+		return [self storeURL];
+	}
+
+	NSString *databaseName = [NSString stringWithFormat:@"%@-%@.sqlite", [self.modelName lowercaseString], [configuration.configurationName lowercaseString]];
+	return [NSURL fileURLWithPath:[[self applicationDocumentsDirectory] stringByAppendingPathComponent:databaseName]];
+}
+
+-(RHStoreConfiguration *)mainStoreConfiguration {
+	for (RHStoreConfiguration *configuration in self.storeConfigurations) {
+		if (configuration.configurationName == nil) {
+			return configuration;
+		}
+	}
+
+	return [self.storeConfigurations firstObject];
+}
+
+// Returns the model configuration the store is added with.  Stores with entityNames get a configuration with those
+// entities, and with more than one store the main store gets one with the remaining entities, so every entity
+// belongs to exactly one store and inserted objects are assigned to it.
+-(NSString *)configurationNameForStore:(RHStoreConfiguration *)configuration model:(NSManagedObjectModel *)model {
+	if (configuration.entityNames) {
+		NSAssert(configuration.configurationName, @"A store configuration with entityNames requires a configurationName.");
+
+		NSMutableArray *entities = [NSMutableArray arrayWithCapacity:[configuration.entityNames count]];
+		for (NSString *entityName in configuration.entityNames) {
+			NSEntityDescription *entity = [[model entitiesByName] objectForKey:entityName];
+			if (entity) {
+				[entities addObject:entity];
+			}
+		}
+
+		[self setEntities:entities forConfigurationName:configuration.configurationName model:model];
+		return configuration.configurationName;
+	}
+
+	if (configuration.configurationName || ([self.storeConfigurations count] < 2)) {
+		return configuration.configurationName;
+	}
+
+	NSMutableSet *assignedEntityNames = [NSMutableSet set];
+	for (RHStoreConfiguration *otherConfiguration in self.storeConfigurations) {
+		if (otherConfiguration.entityNames) {
+			[assignedEntityNames addObjectsFromArray:otherConfiguration.entityNames];
+		} else if (otherConfiguration.configurationName) {
+			for (NSEntityDescription *entity in [model entitiesForConfiguration:otherConfiguration.configurationName]) {
+				[assignedEntityNames addObject:[entity name]];
+			}
+		}
+	}
+
+	NSMutableArray *entities = [NSMutableArray array];
+	for (NSEntityDescription *entity in [model entities]) {
+		if (![assignedEntityNames containsObject:[entity name]]) {
+			[entities addObject:entity];
+		}
+	}
+
+	[self setEntities:entities forConfigurationName:kMainStoreConfigurationName model:model];
+	return kMainStoreConfigurationName;
+}
+
+// A model that was used by a coordinator can't be changed, even if loading its stores failed.  A retry assigns the same
+// entities again, so the model is only changed if the assignment differs.
+-(void)setEntities:(NSArray *)entities forConfigurationName:(NSString *)configurationName model:(NSManagedObjectModel *)model {
+	NSSet *entityNames = [NSSet setWithArray:[entities valueForKey:@"name"]];
+	NSSet *assignedEntityNames = [NSSet setWithArray:[[model entitiesForConfiguration:configurationName] valueForKey:@"name"]];
+
+	if (![[model configurations] containsObject:configurationName] || ![entityNames isEqualToSet:assignedEntityNames]) {
+		[model setEntities:entities forConfigurationName:configurationName];
+	}
+}
+
 -(NSURL *)storeURL {
 	return [NSURL fileURLWithPath:[self storePath]];
 }
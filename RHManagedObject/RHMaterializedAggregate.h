@@ -0,0 +1,140 @@
+//
+//  RHMaterializedAggregate.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHManagedObject.h"
+
+@class RHMaterializedAggregate;
+
+typedef void (^RHMaterializedAggregateChangeBlock)(id value);
+
+
+#pragma mark - RHMaterializedAggregate interface -
+/**
+ RHMaterializedAggregate keeps a count or aggregate (e.g., the number of unread messages or the sum of the salaries in a department) for the objects of an entity that match a predicate. The value is computed once and then updated from the inserted, updated and deleted objects of each commit, so reading it does not access the persistent store. A minimum or maximum is recomputed when its extreme value is removed, and aggregates whose predicate or key follows relationships are recomputed when objects of the related entities are committed. Batch deletes and other changes reported to mergeStoreChanges: also cause a recomputation.
+
+ Create instances with materializedCountWithPredicate:error: or materializedAggregateWithType:key:predicate:error: on an RHManagedObject subclass. The value reflects the persistent store: unsaved changes are not included, and only saves made with commit or commitImmediately are observed.
+
+ RHMaterializedAggregate is thread-safe.
+
+ */
+@interface RHMaterializedAggregate : NSObject
+
+/**
+ *  Initialize an RHMaterializedAggregate instance. The value is not computed until recomputeWithError: is called.
+ *
+ *  @param entityClass The RHManagedObject subclass of the objects.
+ *  @param aggregate   The aggregate type.
+ *  @param key         The name of the attribute, or a key path through to-one relationships. Only RHAggregateCount accepts nil, which counts the objects.
+ *  @param predicate   The predicate that should match with the objects. If nil all objects are aggregated.
+ *
+ *  @return An initialized RHMaterializedAggregate object.
+ */
+-(id)initWithEntityClass:(Class)entityClass
+               aggregate:(RHAggregate)aggregate
+                     key:(NSString *)key
+               predicate:(NSPredicate *)predicate;
+
+@property (nonatomic, readonly) Class entityClass;
+@property (nonatomic, readonly) RHAggregate aggregate;
+@property (nonatomic, readonly) NSString *key;
+@property (nonatomic, readonly) NSPredicate *predicate;
+
+/**
+ *  Whether or not the value is updated from the changed objects. NO if the predicate or key follows relationships or uses subqueries, variables or SELF, in which case the value is recomputed instead.
+ */
+@property (nonatomic, readonly, getter=isIncremental) BOOL incremental;
+
+/**
+ *  The current value: an NSNumber for counts, sums and averages, or the value of the attribute for minimums and maximums. Averages, minimums and maximums are nil while no objects match.
+ */
+@property (readonly) id value;
+
+/**
+ *  This block is executed on the main thread with the new value whenever the value changes.
+ */
+@property (nonatomic, copy) RHMaterializedAggregateChangeBlock changeBlock;
+
+/**
+ *  Computes the value from the persistent store.
+ *
+ *  @param error If an error occurs, upon return contains an NSError object that describes the problem.
+ *
+ *  @return YES if the value was computed.
+ */
+-(BOOL)recomputeWithError:(NSError **)error;
+
+/**
+ *  Marks the value as outdated, so it is recomputed the next time it is read.
+ */
+-(void)setNeedsRecompute;
+
+/**
+ *  Returns whether or not this instance describes the same aggregate as another one.
+ *
+ *  @param aggregate The other instance.
+ *
+ *  @return YES if the entity, aggregate type, key and predicate are equal.
+ */
+-(BOOL)isEqualToMaterializedAggregate:(RHMaterializedAggregate *)aggregate;
+
+
+
+#pragma mark - Maintaining the Value
+/**---------------------------------------------------------------------------------------
+ * @name Maintaining the Value
+ *  ---------------------------------------------------------------------------------------
+ */
+
+/**
+ *  Collects the changes of a managed object context that affect the value. Called by RHManagedObjectContextManager before the managed object context is saved, on the thread of the context.
+ *
+ *  @param moc The managed object context that is about to be saved.
+ *
+ *  @return An object describing the changes, or nil if the value is not affected. Every returned object must be passed to either applyChanges: or discardChanges:.
+ */
+-(id)changesInContext:(NSManagedObjectContext *)moc;
+
+/**
+ *  Updates the value with the changes collected by changesInContext:. Called by RHManagedObjectContextManager after the managed object context was saved, on the thread of the context. A recompute that overlapped the save may already include the changes, so they are then dropped and the value is recomputed the next time it is read.
+ *
+ *  @param changes The changes returned by changesInContext:.
+ */
+-(void)applyChanges:(id)changes;
+
+/**
+ *  Releases the changes collected by changesInContext: without applying them. Called by RHManagedObjectContextManager if the managed object context could not be saved.
+ *
+ *  @param changes The changes returned by changesInContext:.
+ */
+-(void)discardChanges:(id)changes;
+
+/**
+ *  Returns whether or not the value depends on the objects of specific entities, and must be recomputed when they change in the persistent store.
+ *
+ *  @param entityNames The names of the changed entities and their superentities.
+ *
+ *  @return YES if the value depends on one of the entities.
+ */
+-(BOOL)dependsOnEntityNames:(NSSet *)entityNames;
+
+@end
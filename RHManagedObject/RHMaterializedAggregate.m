@@ -0,0 +1,606 @@
+//
+//  RHMaterializedAggregate.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHMaterializedAggregate.h"
+#import "RHManagedObjectContextManager.h"
+
+#define kRemovedValuesKey @"removedValues"
+#define kAddedValuesKey @"addedValues"
+#define kRecomputeKey @"recompute"
+
+@interface RHMaterializedAggregate()
+@property (nonatomic, strong) NSEntityDescription *entity;
+@property (nonatomic, assign) BOOL includesSubentities;
+@property (nonatomic, readwrite, getter=isIncremental) BOOL incremental;
+@property (nonatomic, strong) NSSet *observedKeys;
+@property (nonatomic, strong) NSSet *dependencies;
+@property (nonatomic, assign) NSUInteger count;
+@property (nonatomic, strong) NSDecimalNumber *sum;
+@property (nonatomic, strong) id extreme;
+@property (nonatomic, strong) NSCountedSet *distinctValues;
+@property (nonatomic, assign) BOOL needsRecompute;
+@property (nonatomic, assign) NSUInteger pendingSaveCount;
+@property (nonatomic, assign) NSUInteger saveEpoch;
++(BOOL)addKeysOfPredicate:(NSPredicate *)predicate toSet:(NSMutableSet *)keys;
++(BOOL)addKeysOfExpression:(NSExpression *)expression toSet:(NSMutableSet *)keys;
+-(void)addEntityNamesWithKeyPath:(NSString *)keyPath toSet:(NSMutableSet *)entityNames;
+-(NSDictionary *)committedValuesOfObject:(NSManagedObject *)object;
+-(void)addValueOfObject:(id)object toArray:(NSMutableArray *)values;
+-(BOOL)addValue:(id)value;
+-(BOOL)removeValue:(id)value;
+-(id)currentValue;
+-(id)numberWithDecimalNumber:(NSDecimalNumber *)number;
+-(void)notifyChangeFromValue:(id)oldValue;
+-(void)endSave;
+-(BOOL)matchesEntity:(NSEntityDescription *)entity;
+-(NSDictionary *)incrementalChangesInContext:(NSManagedObjectContext *)moc;
+@end
+
+@implementation RHMaterializedAggregate
+@synthesize value = _value;
+
+-(id)initWithEntityClass:(Class)entityClass
+               aggregate:(RHAggregate)aggregate
+                     key:(NSString *)key
+               predicate:(NSPredicate *)predicate {
+
+	if (self=[super init]) {
+		_entityClass = entityClass;
+		_aggregate = aggregate;
+		_key = [key copy];
+		_predicate = predicate;
+
+		self.entity = [entityClass entityDescriptionWithError:nil];
+		self.includesSubentities = [entityClass shouldFetchRequestsReturnSubentities];
+		self.sum = [NSDecimalNumber zero];
+		self.distinctValues = [NSCountedSet set];
+		self.needsRecompute = YES;
+
+		// Values can only be updated from the changed objects if the predicate and key only use attributes of the entity
+		NSMutableSet *observedKeys = [NSMutableSet set];
+		BOOL incremental = (self.entity != nil) && (predicate == nil || [[self class] addKeysOfPredicate:predicate toSet:observedKeys]);
+
+		if (key) {
+			[observedKeys addObject:key];
+		}
+
+		for (NSString *observedKey in observedKeys) {
+			if ([[self.entity attributesByName] objectForKey:observedKey] == nil) {
+				incremental = NO;
+			}
+		}
+
+		self.incremental = incremental;
+		self.observedKeys = observedKeys;
+
+		if (!incremental) {
+			NSFetchRequest *fetch = [NSFetchRequest new];
+			[fetch setEntity:self.entity];
+			[fetch setPredicate:predicate];
+
+			// nil (e.g., for subqueries) makes every commit recompute the value
+			NSSet *entityNames = nil;
+
+			if (self.entity && [RHQueryCache keyForFetchRequest:fetch resultType:@"aggregate" entityNames:&entityNames]) {
+				NSMutableSet *dependencies = [entityNames mutableCopy];
+				[self addEntityNamesWithKeyPath:key toSet:dependencies];
+				self.dependencies = dependencies;
+			}
+		}
+	}
+	return self;
+}
+
+-(BOOL)isEqualToMaterializedAggregate:(RHMaterializedAggregate *)aggregate {
+	return (self.entityClass == aggregate.entityClass) &&
+	(self.aggregate == aggregate.aggregate) &&
+	((self.key == aggregate.key) || [self.key isEqualToString:aggregate.key]) &&
+	((self.predicate == aggregate.predicate) || [self.predicate isEqual:aggregate.predicate]);
+}
+
+-(id)value {
+	@synchronized(self) {
+		if (!self.needsRecompute) {
+			return _value;
+		}
+	}
+
+	[self recomputeWithError:nil];
+
+	@synchronized(self) {
+		return _value;
+	}
+}
+
+-(void)setNeedsRecompute {
+	@synchronized(self) {
+		self.needsRecompute = YES;
+	}
+}
+
+-(NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %@ %lu(%@) where %@ = %@>", NSStringFromClass([self class]), [self.entityClass entityName], (unsigned long)self.aggregate, self.key, self.predicate, self.value];
+}
+
+#pragma mark -
+#pragma mark Recomputing
+-(BOOL)recomputeWithError:(NSError **)error {
+	NSUInteger count = 0;
+	NSDecimalNumber *sum = [NSDecimalNumber zero];
+	id extreme = nil;
+	NSCountedSet *distinctValues = [NSCountedSet set];
+	NSUInteger saveEpoch = 0;
+
+	@synchronized(self) {
+		saveEpoch = self.saveEpoch;
+	}
+
+	if (self.key == nil) {
+		// countWithPredicate:error: would include the unsaved changes of the current thread
+		NSFetchRequest *fetch = [NSFetchRequest new];
+		[fetch setEntity:self.entity];
+		[fetch setPredicate:self.predicate];
+		[fetch setIncludesSubentities:self.includesSubentities];
+		[fetch setIncludesPendingChanges:NO];
+
+		count = [[self.entityClass managedObjectContextForCurrentThreadWithError:error] countForFetchRequest:fetch error:error];
+
+		if (count == NSNotFound) {
+			return NO;
+		}
+
+	} else if (self.aggregate == RHAggregateCountDistinct) {
+		NSArray *rows = [self.entityClass distinctValuesAndCountsWithAttribute:self.key predicate:self.predicate limit:0 error:error];
+
+		if (rows == nil) {
+			return NO;
+		}
+
+		for (NSDictionary *row in rows) {
+			id value = [row objectForKey:self.key];
+			NSUInteger valueCount = [[row objectForKey:RHDistinctValueCountKey] unsignedIntegerValue];
+
+			if (value == nil) {
+				continue;
+			}
+
+			for (NSUInteger i = 0; i < valueCount; i++) {
+				[distinctValues addObject:value];
+			}
+
+			count += valueCount;
+		}
+
+	} else {
+		// The count of the values is needed to update averages and to know when minimums and maximums become nil
+		NSMutableArray *descriptions = [NSMutableArray arrayWithObject:[RHAggregateDescription aggregateWithType:RHAggregateCount key:self.key name:@"count"]];
+
+		if (self.aggregate == RHAggregateSum || self.aggregate == RHAggregateAverage) {
+			[descriptions addObject:[RHAggregateDescription aggregateWithType:RHAggregateSum key:self.key name:@"value"]];
+		} else if (self.aggregate == RHAggregateMin || self.aggregate == RHAggregateMax) {
+			[descriptions addObject:[RHAggregateDescription aggregateWithType:self.aggregate key:self.key name:@"value"]];
+		}
+
+		NSArray *rows = [self.entityClass aggregatesWithDescriptions:descriptions groupBy:nil having:nil predicate:self.predicate error:error];
+
+		if (rows == nil) {
+			return NO;
+		}
+
+		NSDictionary *row = [rows lastObject];
+		id value = [row objectForKey:@"value"];
+
+		count = [[row objectForKey:@"count"] unsignedIntegerValue];
+
+		if ([value isKindOfClass:[NSNull class]]) {
+			value = nil;
+		}
+
+		if (self.aggregate == RHAggregateSum || self.aggregate == RHAggregateAverage) {
+			sum = value ? [NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]] : [NSDecimalNumber zero];
+		} else if (count > 0) {
+			extreme = value;
+		}
+	}
+
+	id oldValue = nil;
+
+	@synchronized(self) {
+		oldValue = _value;
+
+		self.count = count;
+		self.sum = sum;
+		self.extreme = extreme;
+		self.distinctValues = distinctValues;
+		_value = [self currentValue];
+
+		// A save that is pending or finished during the fetch may or may not be included, so its changes can not be applied on top
+		self.needsRecompute = (self.pendingSaveCount > 0) || (self.saveEpoch != saveEpoch);
+	}
+
+	[self notifyChangeFromValue:oldValue];
+
+	return YES;
+}
+
+#pragma mark -
+#pragma mark Maintaining the value
+-(BOOL)dependsOnEntityNames:(NSSet *)entityNames {
+	if (self.incremental) {
+		return [entityNames containsObject:[self.entity name]];
+	}
+
+	return (self.dependencies == nil) || [self.dependencies intersectsSet:entityNames];
+}
+
+// Changes are matched by the same rule as the fetches of recomputeWithError:, so both paths produce the same value
+-(BOOL)matchesEntity:(NSEntityDescription *)entity {
+	return self.includesSubentities ? [entity isKindOfEntity:self.entity] : [[entity name] isEqualToString:[self.entity name]];
+}
+
+-(id)changesInContext:(NSManagedObjectContext *)moc {
+	id changes = nil;
+
+	if (!self.incremental) {
+		NSMutableSet *entityNames = [NSMutableSet set];
+
+		for (NSSet *objects in [NSArray arrayWithObjects:[moc insertedObjects], [moc updatedObjects], [moc deletedObjects], nil]) {
+			for (NSManagedObject *object in objects) {
+				for (NSEntityDescription *entity = [object entity]; entity; entity = [entity superentity]) {
+					[entityNames addObject:[entity name]];
+				}
+			}
+		}
+
+		if ([self dependsOnEntityNames:entityNames]) {
+			changes = [NSDictionary dictionaryWithObject:[NSNumber numberWithBool:YES] forKey:kRecomputeKey];
+		}
+	} else {
+		changes = [self incrementalChangesInContext:moc];
+	}
+
+	if (changes) {
+		@synchronized(self) {
+			self.pendingSaveCount++;
+		}
+	}
+
+	return changes;
+}
+
+-(NSDictionary *)incrementalChangesInContext:(NSManagedObjectContext *)moc {
+	NSMutableArray *removedValues = [NSMutableArray array];
+	NSMutableArray *addedValues = [NSMutableArray array];
+
+	for (NSManagedObject *object in [moc insertedObjects]) {
+		if ([self matchesEntity:[object entity]] && (self.predicate == nil || [self.predicate evaluateWithObject:object])) {
+			[self addValueOfObject:object toArray:addedValues];
+		}
+	}
+
+	for (NSManagedObject *object in [moc deletedObjects]) {
+		if ([self matchesEntity:[object entity]]) {
+			NSDictionary *committedValues = [self committedValuesOfObject:object];
+
+			if (self.predicate == nil || [self.predicate evaluateWithObject:committedValues]) {
+				[self addValueOfObject:committedValues toArray:removedValues];
+			}
+		}
+	}
+
+	for (NSManagedObject *object in [moc updatedObjects]) {
+		// Objects are only re-evaluated if an attribute of the predicate or the key changed
+		if (![self matchesEntity:[object entity]] || ![self.observedKeys intersectsSet:[NSSet setWithArray:[[object changedValues] allKeys]]]) {
+			continue;
+		}
+
+		NSDictionary *committedValues = [self committedValuesOfObject:object];
+
+		if (self.predicate == nil || [self.predicate evaluateWithObject:committedValues]) {
+			[self addValueOfObject:committedValues toArray:removedValues];
+		}
+
+		if (self.predicate == nil || [self.predicate evaluateWithObject:object]) {
+			[self addValueOfObject:object toArray:addedValues];
+		}
+	}
+
+	if (([removedValues count] == 0) && ([addedValues count] == 0)) {
+		return nil;
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:removedValues, kRemovedValuesKey, addedValues, kAddedValuesKey, nil];
+}
+
+-(void)discardChanges:(id)changes {
+	[self endSave];
+}
+
+-(void)endSave {
+	@synchronized(self) {
+		self.pendingSaveCount--;
+		self.saveEpoch++;
+	}
+}
+
+-(void)applyChanges:(id)changes {
+	[self endSave];
+
+	if ([[changes objectForKey:kRecomputeKey] boolValue]) {
+		[self recomputeWithError:nil];
+		return;
+	}
+
+	id oldValue = nil;
+	BOOL recompute = NO;
+
+	@synchronized(self) {
+		if (self.needsRecompute) {
+			return;
+		}
+
+		oldValue = _value;
+
+		for (id value in [changes objectForKey:kRemovedValuesKey]) {
+			if (![self removeValue:value]) {
+				recompute = YES;
+			}
+		}
+
+		for (id value in [changes objectForKey:kAddedValuesKey]) {
+			[self addValue:value];
+		}
+
+		_value = [self currentValue];
+	}
+
+	if (recompute) {
+		[self recomputeWithError:nil];
+	} else {
+		[self notifyChangeFromValue:oldValue];
+	}
+}
+
+// committedValuesForKeys: represents nil with NSNull, which predicates do not treat as nil
+-(NSDictionary *)committedValuesOfObject:(NSManagedObject *)object {
+	NSMutableDictionary *committedValues = [NSMutableDictionary dictionary];
+
+	[[object committedValuesForKeys:[self.observedKeys allObjects]] enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+		if (![value isKindOfClass:[NSNull class]]) {
+			[committedValues setObject:value forKey:key];
+		}
+	}];
+
+	return committedValues;
+}
+
+// Counts of objects use NSNull as value; like the persistent store, other aggregates ignore nil values
+-(void)addValueOfObject:(id)object toArray:(NSMutableArray *)values {
+	id value = self.key ? [object valueForKey:self.key] : [NSNull null];
+
+	if (value) {
+		[values addObject:value];
+	}
+}
+
+-(BOOL)addValue:(id)value {
+	self.count++;
+
+	switch (self.aggregate) {
+		case RHAggregateSum:
+		case RHAggregateAverage:
+			self.sum = [self.sum decimalNumberByAdding:[NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]]];
+			break;
+
+		case RHAggregateMin:
+			if ((self.extreme == nil) || ([value compare:self.extreme] == NSOrderedAscending)) {
+				self.extreme = value;
+			}
+			break;
+
+		case RHAggregateMax:
+			if ((self.extreme == nil) || ([value compare:self.extreme] == NSOrderedDescending)) {
+				self.extreme = value;
+			}
+			break;
+
+		case RHAggregateCountDistinct:
+			[self.distinctValues addObject:value];
+			break;
+
+		default:
+			break;
+	}
+
+	return YES;
+}
+
+// Returns NO if the value can not be removed without recomputing
+-(BOOL)removeValue:(id)value {
+	if (self.count == 0) {
+		return NO;
+	}
+
+	self.count--;
+
+	switch (self.aggregate) {
+		case RHAggregateSum:
+		case RHAggregateAverage:
+			self.sum = [self.sum decimalNumberBySubtracting:[NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]]];
+			return YES;
+
+		case RHAggregateMin:
+		case RHAggregateMax:
+			// Another object may have the same value, or the next one is unknown
+			if (self.count == 0) {
+				self.extreme = nil;
+				return YES;
+			}
+			return ([value compare:self.extreme] != NSOrderedSame);
+
+		case RHAggregateCountDistinct:
+			[self.distinctValues removeObject:value];
+			return YES;
+
+		default:
+			return YES;
+	}
+}
+
+-(id)currentValue {
+	switch (self.aggregate) {
+		case RHAggregateSum:
+			return [self numberWithDecimalNumber:self.sum];
+
+		case RHAggregateAverage:
+			if (self.count == 0) {
+				return nil;
+			}
+			return [self numberWithDecimalNumber:[self.sum decimalNumberByDividingBy:(NSDecimalNumber *)[NSDecimalNumber numberWithUnsignedInteger:self.count]]];
+
+		case RHAggregateMin:
+		case RHAggregateMax:
+			return self.extreme;
+
+		case RHAggregateCountDistinct:
+			return [NSNumber numberWithUnsignedInteger:[self.distinctValues count]];
+
+		default:
+			return [NSNumber numberWithUnsignedInteger:self.count];
+	}
+}
+
+// Sums are kept as decimal numbers so floating point errors do not accumulate over many commits
+-(id)numberWithDecimalNumber:(NSDecimalNumber *)number {
+	NSAttributeType attributeType = [self.entityClass attributeTypeWithKey:self.key error:nil];
+
+	switch (attributeType) {
+		case NSDecimalAttributeType:
+			return number;
+
+		case NSInteger16AttributeType:
+		case NSInteger32AttributeType:
+		case NSInteger64AttributeType:
+			if (self.aggregate == RHAggregateSum) {
+				return [NSNumber numberWithLongLong:[number longLongValue]];
+			}
+			return [NSNumber numberWithDouble:[number doubleValue]];
+
+		default:
+			return [NSNumber numberWithDouble:[number doubleValue]];
+	}
+}
+
+-(void)notifyChangeFromValue:(id)oldValue {
+	id newValue = nil;
+	RHMaterializedAggregateChangeBlock changeBlock = nil;
+
+	@synchronized(self) {
+		newValue = _value;
+		changeBlock = self.changeBlock;
+	}
+
+	if ((changeBlock == nil) || (newValue == oldValue) || [newValue isEqual:oldValue]) {
+		return;
+	}
+
+	dispatch_async(dispatch_get_main_queue(), ^{
+		changeBlock(newValue);
+	});
+}
+
+#pragma mark -
+#pragma mark Predicates
++(BOOL)addKeysOfPredicate:(NSPredicate *)predicate toSet:(NSMutableSet *)keys {
+	if ([predicate isKindOfClass:[NSCompoundPredicate class]]) {
+		for (NSPredicate *subpredicate in [(NSCompoundPredicate *)predicate subpredicates]) {
+			if (![self addKeysOfPredicate:subpredicate toSet:keys]) {
+				return NO;
+			}
+		}
+		return YES;
+	}
+
+	if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+		NSComparisonPredicate *comparisonPredicate = (NSComparisonPredicate *)predicate;
+
+		return [self addKeysOfExpression:[comparisonPredicate leftExpression] toSet:keys] &&
+		[self addKeysOfExpression:[comparisonPredicate rightExpression] toSet:keys];
+	}
+
+	// [NSPredicate predicateWithValue:]
+	NSString *format = [predicate predicateFormat];
+	return [format isEqualToString:@"TRUEPREDICATE"] || [format isEqualToString:@"FALSEPREDICATE"];
+}
+
++(BOOL)addKeysOfExpression:(NSExpression *)expression toSet:(NSMutableSet *)keys {
+	switch ([expression expressionType]) {
+		case NSConstantValueExpressionType:
+			return YES;
+
+		case NSKeyPathExpressionType:
+			[keys addObject:[expression keyPath]];
+			return YES;
+
+		case NSFunctionExpressionType:
+			if (![self addKeysOfExpression:[expression operand] toSet:keys]) {
+				return NO;
+			}
+
+			for (NSExpression *argument in [expression arguments]) {
+				if (![self addKeysOfExpression:argument toSet:keys]) {
+					return NO;
+				}
+			}
+			return YES;
+
+		case NSAggregateExpressionType:
+			for (NSExpression *element in [expression collection]) {
+				if (![self addKeysOfExpression:element toSet:keys]) {
+					return NO;
+				}
+			}
+			return YES;
+
+		default:
+			// SELF can not be evaluated with the committed values, subqueries and variables are not supported
+			return NO;
+	}
+}
+
+-(void)addEntityNamesWithKeyPath:(NSString *)keyPath toSet:(NSMutableSet *)entityNames {
+	NSEntityDescription *entity = self.entity;
+
+	for (NSString *component in [keyPath componentsSeparatedByString:@"."]) {
+		NSRelationshipDescription *relationship = [[entity relationshipsByName] objectForKey:component];
+
+		if (relationship == nil) {
+			return;
+		}
+
+		entity = [relationship destinationEntity];
+		[entityNames addObject:[entity name]];
+	}
+}
+
+@end
@@ -0,0 +1,110 @@
+//
+//  RHQueryCache.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#define kQueryCacheCapacity 256 // Default maximum number of cached query results
+
+#define RHQueryCacheHitCountKey @"hitCount"
+#define RHQueryCacheMissCountKey @"missCount"
+#define RHQueryCacheEvictionCountKey @"evictionCount"
+#define RHQueryCacheInvalidationCountKey @"invalidationCount"
+#define RHQueryCacheObjectCountKey @"objectCount"
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHQueryCache interface -
+/**
+ RHQueryCache holds the results of queries (e.g., arrays of object IDs or counts) together with the entities they depend on. When objects of an entity change, every result that depends on the entity is removed. The least recently used results are evicted once the capacity is reached. RHQueryCache is thread-safe.
+
+ */
+@interface RHQueryCache : NSObject
+
+/**
+ *  Initialize an RHQueryCache instance.
+ *
+ *  @param capacity The maximum number of cached results.
+ *
+ *  @return An initialized RHQueryCache object.
+ */
+-(id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ *  Returns the key of a fetch request and the names of the entities its result depends on: the entity of the request and the destination entities of the relationships in the key paths of the predicate and the sort descriptors.
+ *
+ *  @param fetchRequest The fetch request.
+ *  @param resultType   A string that distinguishes the kind of result (e.g., @"fetch" or @"count").
+ *  @param entityNames  Upon return contains the names of the entities the result depends on.
+ *
+ *  @return The key, or nil if the fetch request can not be cached (e.g., it has a batch size, properties to fetch, a subquery, variables or constants that can not be compared reliably, it asks for objects that are not faults, or it matches a list of objects or object IDs).
+ */
++(NSString *)keyForFetchRequest:(NSFetchRequest *)fetchRequest resultType:(NSString *)resultType entityNames:(NSSet **)entityNames;
+
+/**
+ *  The maximum number of cached results. Lowering the capacity evicts the least recently used results right away.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ *  A number that changes whenever results are invalidated. Read it before executing a query and pass it to setObject:forKey:entityNames:generation:, so a result that was invalidated while the query was executed is not cached.
+ */
+@property (nonatomic, readonly) NSUInteger generation;
+
+/**
+ *  Returns a cached result and counts a hit, or counts a miss if there is none.
+ *
+ *  @param key The key of the query.
+ *
+ *  @return The cached result or nil.
+ */
+-(id)objectForKey:(NSString *)key;
+
+/**
+ *  Caches a result.
+ *
+ *  @param object      The result.
+ *  @param key         The key of the query.
+ *  @param entityNames The names of the entities the result depends on.
+ *  @param generation  The generation read before the query was executed. The result is not cached if results were invalidated since.
+ */
+-(void)setObject:(id)object forKey:(NSString *)key entityNames:(NSSet *)entityNames generation:(NSUInteger)generation;
+
+/**
+ *  Removes the results that depend on specific entities.
+ *
+ *  @param entityNames The names of the changed entities.
+ */
+-(void)invalidateEntityNames:(NSSet *)entityNames;
+
+/**
+ *  Removes all results.
+ */
+-(void)removeAllObjects;
+
+/**
+ *  Returns statistics about the cache. The keys are RHQueryCacheHitCountKey, RHQueryCacheMissCountKey, RHQueryCacheEvictionCountKey (results removed because of the capacity), RHQueryCacheInvalidationCountKey (results removed because an entity changed) and RHQueryCacheObjectCountKey (the number of cached results).
+ *
+ *  @return A dictionary with NSNumber values.
+ */
+-(NSDictionary *)statistics;
+
+@end
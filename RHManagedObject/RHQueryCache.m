@@ -0,0 +1,420 @@
+//
+//  RHQueryCache.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHQueryCache.h"
+
+@interface RHQueryCache()
+@property (nonatomic, strong) NSMutableDictionary *objects;
+@property (nonatomic, strong) NSMutableDictionary *entityNamesByKey;
+@property (nonatomic, strong) NSMutableDictionary *keysByEntityName;
+@property (nonatomic, strong) NSMutableOrderedSet *recentKeys;
+@property (nonatomic, readwrite) NSUInteger generation;
+@property (nonatomic, assign) NSUInteger hitCount;
+@property (nonatomic, assign) NSUInteger missCount;
+@property (nonatomic, assign) NSUInteger evictionCount;
+@property (nonatomic, assign) NSUInteger invalidationCount;
+-(void)removeObjectForKey:(NSString *)key;
++(BOOL)appendPredicate:(NSPredicate *)predicate toKey:(NSMutableString *)key entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames;
++(BOOL)appendExpression:(NSExpression *)expression toKey:(NSMutableString *)key entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames;
++(BOOL)appendConstant:(id)constant toKey:(NSMutableString *)key;
++(BOOL)isObjectReference:(id)constant;
++(void)addEntityNamesWithKeyPath:(NSString *)keyPath entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames;
+@end
+
+@implementation RHQueryCache
+
+-(id)init {
+	return [self initWithCapacity:kQueryCacheCapacity];
+}
+
+-(id)initWithCapacity:(NSUInteger)capacity {
+	if (self=[super init]) {
+		self.objects = [NSMutableDictionary dictionary];
+		self.entityNamesByKey = [NSMutableDictionary dictionary];
+		self.keysByEntityName = [NSMutableDictionary dictionary];
+		self.recentKeys = [NSMutableOrderedSet orderedSet];
+		self.capacity = capacity;
+	}
+	return self;
+}
+
+-(void)setCapacity:(NSUInteger)capacity {
+	@synchronized(self) {
+		_capacity = capacity;
+
+		while ([self.recentKeys count] > capacity) {
+			[self removeObjectForKey:[self.recentKeys firstObject]];
+			self.evictionCount++;
+		}
+	}
+}
+
+-(id)objectForKey:(NSString *)key {
+	@synchronized(self) {
+		id object = [self.objects objectForKey:key];
+
+		if (object) {
+			// The most recently used key is last, so eviction takes the first
+			[self.recentKeys removeObject:key];
+			[self.recentKeys addObject:key];
+			self.hitCount++;
+		} else {
+			self.missCount++;
+		}
+
+		return object;
+	}
+}
+
+-(void)setObject:(id)object forKey:(NSString *)key entityNames:(NSSet *)entityNames generation:(NSUInteger)generation {
+	@synchronized(self) {
+		if ((generation != self.generation) || (self.capacity == 0)) {
+			return;
+		}
+
+		[self removeObjectForKey:key];
+
+		while ([self.recentKeys count] >= self.capacity) {
+			[self removeObjectForKey:[self.recentKeys firstObject]];
+			self.evictionCount++;
+		}
+
+		[self.objects setObject:object forKey:key];
+		[self.entityNamesByKey setObject:entityNames forKey:key];
+		[self.recentKeys addObject:key];
+
+		for (NSString *entityName in entityNames) {
+			NSMutableSet *keys = [self.keysByEntityName objectForKey:entityName];
+			if (keys == nil) {
+				keys = [NSMutableSet set];
+				[self.keysByEntityName setObject:keys forKey:entityName];
+			}
+			[keys addObject:key];
+		}
+	}
+}
+
+-(void)removeObjectForKey:(NSString *)key {
+	if ([self.objects objectForKey:key] == nil) {
+		return;
+	}
+
+	for (NSString *entityName in [self.entityNamesByKey objectForKey:key]) {
+		NSMutableSet *keys = [self.keysByEntityName objectForKey:entityName];
+		[keys removeObject:key];
+
+		if ([keys count] == 0) {
+			[self.keysByEntityName removeObjectForKey:entityName];
+		}
+	}
+
+	[self.objects removeObjectForKey:key];
+	[self.entityNamesByKey removeObjectForKey:key];
+	[self.recentKeys removeObject:key];
+}
+
+-(void)invalidateEntityNames:(NSSet *)entityNames {
+	@synchronized(self) {
+		self.generation++;
+
+		for (NSString *entityName in entityNames) {
+			for (NSString *key in [[self.keysByEntityName objectForKey:entityName] allObjects]) {
+				[self removeObjectForKey:key];
+				self.invalidationCount++;
+			}
+		}
+	}
+}
+
+-(void)removeAllObjects {
+	@synchronized(self) {
+		self.generation++;
+
+		[self.objects removeAllObjects];
+		[self.entityNamesByKey removeAllObjects];
+		[self.keysByEntityName removeAllObjects];
+		[self.recentKeys removeAllObjects];
+	}
+}
+
+-(NSDictionary *)statistics {
+	@synchronized(self) {
+		return [NSDictionary dictionaryWithObjectsAndKeys:
+				[NSNumber numberWithUnsignedInteger:self.hitCount], RHQueryCacheHitCountKey,
+				[NSNumber numberWithUnsignedInteger:self.missCount], RHQueryCacheMissCountKey,
+				[NSNumber numberWithUnsignedInteger:self.evictionCount], RHQueryCacheEvictionCountKey,
+				[NSNumber numberWithUnsignedInteger:self.invalidationCount], RHQueryCacheInvalidationCountKey,
+				[NSNumber numberWithUnsignedInteger:[self.objects count]], RHQueryCacheObjectCountKey,
+				nil];
+	}
+}
+
+#pragma mark -
+#pragma mark Keys
++(NSString *)keyForFetchRequest:(NSFetchRequest *)fetchRequest resultType:(NSString *)resultType entityNames:(NSSet **)entityNames {
+	NSEntityDescription *entity = [fetchRequest entity];
+
+	if ((entity == nil) || ([fetchRequest fetchBatchSize] > 0) || [fetchRequest propertiesToFetch] || [fetchRequest relationshipKeyPathsForPrefetching]) {
+		return nil;
+	}
+
+	// Cached results are returned as faults, which is not what a request for fully loaded objects asked for
+	if (![fetchRequest returnsObjectsAsFaults] || ![fetchRequest includesPropertyValues]) {
+		return nil;
+	}
+
+	NSMutableSet *dependencies = [NSMutableSet setWithObject:[entity name]];
+	NSMutableString *key = [NSMutableString stringWithFormat:@"%@|%@|%d|%lu|%lu|", resultType, [entity name], [fetchRequest includesSubentities], (unsigned long)[fetchRequest fetchLimit], (unsigned long)[fetchRequest fetchOffset]];
+
+	if ([fetchRequest predicate] && ![self appendPredicate:[fetchRequest predicate] toKey:key entity:entity entityNames:dependencies]) {
+		return nil;
+	}
+
+	for (NSSortDescriptor *sortDescriptor in [fetchRequest sortDescriptors]) {
+		if ([sortDescriptor key] == nil) {
+			return nil;
+		}
+
+		[key appendFormat:@"|%@ %d %@", [sortDescriptor key], [sortDescriptor ascending], NSStringFromSelector([sortDescriptor selector])];
+		[self addEntityNamesWithKeyPath:[sortDescriptor key] entity:entity entityNames:dependencies];
+	}
+
+	if (entityNames) {
+		*entityNames = dependencies;
+	}
+
+	return key;
+}
+
++(BOOL)appendPredicate:(NSPredicate *)predicate toKey:(NSMutableString *)key entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames {
+	if ([predicate isKindOfClass:[NSCompoundPredicate class]]) {
+		NSCompoundPredicate *compoundPredicate = (NSCompoundPredicate *)predicate;
+
+		[key appendFormat:@"(%lu", (unsigned long)[compoundPredicate compoundPredicateType]];
+
+		for (NSPredicate *subpredicate in [compoundPredicate subpredicates]) {
+			[key appendString:@" "];
+
+			if (![self appendPredicate:subpredicate toKey:key entity:entity entityNames:entityNames]) {
+				return NO;
+			}
+		}
+
+		[key appendString:@")"];
+		return YES;
+	}
+
+	if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+		NSComparisonPredicate *comparisonPredicate = (NSComparisonPredicate *)predicate;
+
+		if ([comparisonPredicate predicateOperatorType] == NSCustomSelectorPredicateOperatorType) {
+			return NO;
+		}
+
+		[key appendFormat:@"[%lu %lu %lu ", (unsigned long)[comparisonPredicate predicateOperatorType], (unsigned long)[comparisonPredicate comparisonPredicateModifier], (unsigned long)[comparisonPredicate options]];
+
+		if (![self appendExpression:[comparisonPredicate leftExpression] toKey:key entity:entity entityNames:entityNames]) {
+			return NO;
+		}
+
+		[key appendString:@" "];
+
+		if (![self appendExpression:[comparisonPredicate rightExpression] toKey:key entity:entity entityNames:entityNames]) {
+			return NO;
+		}
+
+		[key appendString:@"]"];
+		return YES;
+	}
+
+	// [NSPredicate predicateWithValue:]
+	NSString *format = [predicate predicateFormat];
+
+	if ([format isEqualToString:@"TRUEPREDICATE"] || [format isEqualToString:@"FALSEPREDICATE"]) {
+		[key appendString:format];
+		return YES;
+	}
+
+	return NO;
+}
+
++(BOOL)appendExpression:(NSExpression *)expression toKey:(NSMutableString *)key entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames {
+	switch ([expression expressionType]) {
+		case NSConstantValueExpressionType:
+			return [self appendConstant:[expression constantValue] toKey:key];
+
+		case NSEvaluatedObjectExpressionType:
+			[key appendString:@"SELF"];
+			return YES;
+
+		case NSKeyPathExpressionType:
+			[key appendFormat:@"k%@", [expression keyPath]];
+			[self addEntityNamesWithKeyPath:[expression keyPath] entity:entity entityNames:entityNames];
+			return YES;
+
+		case NSFunctionExpressionType:
+			[key appendFormat:@"f%@(", [expression function]];
+
+			if (![self appendExpression:[expression operand] toKey:key entity:entity entityNames:entityNames]) {
+				return NO;
+			}
+
+			for (NSExpression *argument in [expression arguments]) {
+				[key appendString:@","];
+
+				if (![self appendExpression:argument toKey:key entity:entity entityNames:entityNames]) {
+					return NO;
+				}
+			}
+
+			[key appendString:@")"];
+			return YES;
+
+		case NSAggregateExpressionType:
+			[key appendString:@"{"];
+
+			for (NSExpression *element in [expression collection]) {
+				if (([element expressionType] == NSConstantValueExpressionType) && [self isObjectReference:[element constantValue]]) {
+					return NO;
+				}
+
+				if (![self appendExpression:element toKey:key entity:entity entityNames:entityNames]) {
+					return NO;
+				}
+
+				[key appendString:@","];
+			}
+
+			[key appendString:@"}"];
+			return YES;
+
+		default:
+			// Variables, subqueries, blocks, etc.
+			return NO;
+	}
+}
+
++(BOOL)appendConstant:(id)constant toKey:(NSMutableString *)key {
+	// Lists of objects (e.g., self IN %@ with object IDs) are rarely repeated and make large keys that push out useful results
+	if ([constant isKindOfClass:[NSArray class]] || [constant isKindOfClass:[NSOrderedSet class]] || [constant isKindOfClass:[NSSet class]]) {
+		for (id element in constant) {
+			if ([self isObjectReference:element]) {
+				return NO;
+			}
+		}
+	}
+
+	if ((constant == nil) || [constant isKindOfClass:[NSNull class]]) {
+		[key appendString:@"nil"];
+
+	} else if ([constant isKindOfClass:[NSString class]]) {
+		// The length prefix keeps strings with separators from colliding
+		[key appendFormat:@"s%lu:%@", (unsigned long)[constant length], constant];
+
+	} else if ([constant isKindOfClass:[NSNumber class]]) {
+		const char *type = [constant objCType];
+
+		// Descriptions of floating point numbers are rounded
+		if ((strcmp(type, @encode(double)) == 0) || (strcmp(type, @encode(float)) == 0)) {
+			[key appendFormat:@"n%a", [constant doubleValue]];
+		} else {
+			[key appendFormat:@"n%@", [constant stringValue]];
+		}
+
+	} else if ([constant isKindOfClass:[NSDate class]]) {
+		// Descriptions of dates are rounded to seconds
+		[key appendFormat:@"d%a", [constant timeIntervalSinceReferenceDate]];
+
+	} else if ([constant isKindOfClass:[NSManagedObject class]] || [constant isKindOfClass:[NSManagedObjectID class]]) {
+		NSManagedObjectID *objectID = [constant isKindOfClass:[NSManagedObject class]] ? [constant objectID] : constant;
+
+		if ([objectID isTemporaryID]) {
+			return NO;
+		}
+
+		[key appendFormat:@"o%@", [[objectID URIRepresentation] absoluteString]];
+
+	} else if ([constant isKindOfClass:[NSUUID class]]) {
+		[key appendFormat:@"u%@", [constant UUIDString]];
+
+	} else if ([constant isKindOfClass:[NSURL class]]) {
+		[key appendFormat:@"l%@", [constant absoluteString]];
+
+	} else if ([constant isKindOfClass:[NSData class]]) {
+		[key appendFormat:@"b%@", [constant base64EncodedStringWithOptions:0]];
+
+	} else if ([constant isKindOfClass:[NSArray class]] || [constant isKindOfClass:[NSOrderedSet class]]) {
+		[key appendString:@"{"];
+
+		for (id element in constant) {
+			if (![self appendConstant:element toKey:key]) {
+				return NO;
+			}
+
+			[key appendString:@","];
+		}
+
+		[key appendString:@"}"];
+
+	} else if ([constant isKindOfClass:[NSSet class]]) {
+		// Sets have no order, so the keys of the elements are sorted
+		NSMutableArray *elementKeys = [NSMutableArray arrayWithCapacity:[constant count]];
+
+		for (id element in constant) {
+			NSMutableString *elementKey = [NSMutableString string];
+
+			if (![self appendConstant:element toKey:elementKey]) {
+				return NO;
+			}
+
+			[elementKeys addObject:elementKey];
+		}
+
+		[key appendFormat:@"{%@}", [[elementKeys sortedArrayUsingSelector:@selector(compare:)] componentsJoinedByString:@","]];
+
+	} else {
+		return NO;
+	}
+
+	return YES;
+}
+
++(BOOL)isObjectReference:(id)constant {
+	return [constant isKindOfClass:[NSManagedObject class]] || [constant isKindOfClass:[NSManagedObjectID class]];
+}
+
++(void)addEntityNamesWithKeyPath:(NSString *)keyPath entity:(NSEntityDescription *)entity entityNames:(NSMutableSet *)entityNames {
+	for (NSString *component in [keyPath componentsSeparatedByString:@"."]) {
+		NSRelationshipDescription *relationship = [[entity relationshipsByName] objectForKey:component];
+
+		// Attributes and collection operators (e.g., @count) end the relationships of the key path
+		if (relationship == nil) {
+			return;
+		}
+
+		entity = [relationship destinationEntity];
+		[entityNames addObject:[entity name]];
+	}
+}
+
+@end
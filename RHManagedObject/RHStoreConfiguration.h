@@ -0,0 +1,124 @@
+//
+//  RHStoreConfiguration.h
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import <CoreData/CoreData.h>
+
+
+#pragma mark - RHStoreConfiguration interface -
+/**
+ RHStoreConfiguration describes the persistent store of a data model: where it is stored, its type, the SQLite pragmas and the options it is added with. Different models in the same application can be tuned differently, e.g., a write-heavy ingest model with synchronous=OFF and a read-mostly catalog model with a large mmap_size.
+
+ Register a configuration with [RHManagedObjectContextManager setStoreConfiguration:forModelName:] before the model is first used. Models without a registered configuration use the defaults: an SQLite store at Documents/<model>.sqlite with lightweight migration.
+
+ A data model can also be split over several stores with [RHManagedObjectContextManager setStoreConfigurations:forModelName:], e.g., a persistent SQLite store for user data and an in-memory store for cached API responses. Each store holds the entities of one model configuration, so objects are saved to and fetched from the right store automatically.
+
+ */
+@interface RHStoreConfiguration : NSObject <NSCopying>
+
+/**
+ *  The type of the persistent store, NSSQLiteStoreType or NSInMemoryStoreType. An in-memory store has no file and its contents are lost when the store is deleted or the application terminates. Defaults to NSSQLiteStoreType.
+ */
+@property (nonatomic, strong) NSString *storeType;
+
+/**
+ *  The file URL of the database. If nil the database is stored in the application's documents directory, named after the data model (and the configuration name for stores other than the main store). Ignored for in-memory stores.
+ */
+@property (nonatomic, strong) NSURL *storeURL;
+
+/**
+ *  The SQLite journal mode, e.g., @"WAL", @"DELETE" or @"TRUNCATE". If nil the Core Data default (WAL) is used.
+ */
+@property (nonatomic, strong) NSString *journalMode;
+
+/**
+ *  The SQLite synchronous setting, @"OFF", @"NORMAL" or @"FULL". OFF is fastest for writes but may lose the last transactions on power loss. If nil the SQLite default is used.
+ */
+@property (nonatomic, strong) NSString *synchronous;
+
+/**
+ *  The SQLite page cache size. Positive values are a number of pages, negative values a size in KiB. If nil the SQLite default is used.
+ */
+@property (nonatomic, strong) NSNumber *cacheSize;
+
+/**
+ *  The maximum number of bytes of the database that SQLite accesses through memory-mapped I/O. 0 disables memory mapping. If nil the SQLite default is used.
+ */
+@property (nonatomic, strong) NSNumber *mmapSize;
+
+/**
+ *  Where SQLite stores temporary tables and indices, @"DEFAULT", @"FILE" or @"MEMORY". If nil the SQLite default is used.
+ */
+@property (nonatomic, strong) NSString *tempStore;
+
+/**
+ *  Additional SQLite pragmas with the pragma names as keys. These take precedence over the properties above.
+ */
+@property (nonatomic, strong) NSDictionary *pragmas;
+
+/**
+ *  The name of the model configuration whose entities are stored in this store. If nil the store holds all entities that are not assigned to another store.
+ */
+@property (nonatomic, strong) NSString *configurationName;
+
+/**
+ *  The names of the entities stored in this store. If set, the entities are assigned to the model configuration configurationName (which must be set) when the store is added, so the configuration does not need to be defined in the data model. Subentities must be stored with their parent entity.
+ */
+@property (nonatomic, strong) NSArray *entityNames;
+
+/**
+ *  Whether or not the store records persistent history (NSPersistentHistoryTrackingKey). Only available on iOS 11 and later. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL recordsPersistentHistory;
+
+/**
+ *  Whether or not the store is migrated automatically with an inferred mapping model when the data model changed. Defaults to YES.
+ */
+@property (nonatomic, assign) BOOL migratesAutomatically;
+
+/**
+ *  Additional options the persistent store is added with. These take precedence over the options derived from the properties above.
+ */
+@property (nonatomic, strong) NSDictionary *options;
+
+/**
+ *  Returns whether or not the persistent store is an SQLite store.
+ *
+ *  @return YES if storeType is NSSQLiteStoreType, otherwise NO.
+ */
+-(BOOL)isSQLiteStore;
+
+/**
+ *  Returns the SQLite pragmas derived from journalMode, synchronous, cacheSize, mmapSize, tempStore and pragmas.
+ *
+ *  @return A dictionary with the pragma names as keys and strings as values.
+ */
+-(NSDictionary *)sqlitePragmas;
+
+/**
+ *  Returns the options the persistent store is added with.
+ *
+ *  @return The options for addPersistentStoreWithType:configuration:URL:options:error:.
+ */
+-(NSDictionary *)storeOptions;
+
+@end
@@ -0,0 +1,119 @@
+//
+//  RHStoreConfiguration.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+#import "RHStoreConfiguration.h"
+
+@implementation RHStoreConfiguration
+
+-(id)init {
+	if (self=[super init]) {
+		self.storeType = NSSQLiteStoreType;
+		self.migratesAutomatically = YES;
+	}
+	return self;
+}
+
+-(id)copyWithZone:(NSZone *)zone {
+	RHStoreConfiguration *configuration = [[[self class] allocWithZone:zone] init];
+
+	configuration.storeType = self.storeType;
+	configuration.storeURL = self.storeURL;
+	configuration.journalMode = self.journalMode;
+	configuration.synchronous = self.synchronous;
+	configuration.cacheSize = self.cacheSize;
+	configuration.mmapSize = self.mmapSize;
+	configuration.tempStore = self.tempStore;
+	configuration.pragmas = self.pragmas;
+	configuration.configurationName = self.configurationName;
+	configuration.entityNames = self.entityNames;
+	configuration.recordsPersistentHistory = self.recordsPersistentHistory;
+	configuration.migratesAutomatically = self.migratesAutomatically;
+	configuration.options = self.options;
+
+	return configuration;
+}
+
+-(BOOL)isSQLiteStore {
+	return [self.storeType isEqualToString:NSSQLiteStoreType];
+}
+
+-(NSDictionary *)sqlitePragmas {
+	NSMutableDictionary *pragmas = [NSMutableDictionary dictionary];
+
+	if (self.journalMode) {
+		[pragmas setObject:self.journalMode forKey:@"journal_mode"];
+	}
+
+	if (self.synchronous) {
+		[pragmas setObject:self.synchronous forKey:@"synchronous"];
+	}
+
+	if (self.cacheSize) {
+		[pragmas setObject:[self.cacheSize stringValue] forKey:@"cache_size"];
+	}
+
+	if (self.mmapSize) {
+		[pragmas setObject:[self.mmapSize stringValue] forKey:@"mmap_size"];
+	}
+
+	if (self.tempStore) {
+		[pragmas setObject:self.tempStore forKey:@"temp_store"];
+	}
+
+	for (NSString *name in self.pragmas) {
+		id value = [self.pragmas objectForKey:name];
+		[pragmas setObject:[value isKindOfClass:[NSString class]] ? value : [value description] forKey:name];
+	}
+
+	return pragmas;
+}
+
+-(NSDictionary *)storeOptions {
+	NSMutableDictionary *options = [NSMutableDictionary dictionary];
+
+	// https://developer.apple.com/library/mac/#documentation/Cocoa/Conceptual/CoreDataVersioning/Articles/vmLightweightMigration.html#//apple_ref/doc/uid/TP40004399-CH4-SW1
+	if (self.migratesAutomatically) {
+		[options setObject:[NSNumber numberWithBool:YES] forKey:NSMigratePersistentStoresAutomaticallyOption];
+		[options setObject:[NSNumber numberWithBool:YES] forKey:NSInferMappingModelAutomaticallyOption];
+	}
+
+	if ([self isSQLiteStore]) {
+		NSDictionary *pragmas = [self sqlitePragmas];
+
+		if ([pragmas count] > 0) {
+			[options setObject:pragmas forKey:NSSQLitePragmasOption];
+		}
+	}
+
+	if (self.recordsPersistentHistory) {
+		if (@available(iOS 11.0, macOS 10.13, *)) {
+			[options setObject:[NSNumber numberWithBool:YES] forKey:NSPersistentHistoryTrackingKey];
+		}
+	}
+
+	[options addEntriesFromDictionary:self.options];
+
+	return options;
+}
+
+@end
@@ -0,0 +1,137 @@
+//
+//  RHStoreLoadingSpec.m
+//
+//  Copyright (C) 2026 by the RHManagedObject contributors
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+
+// Command line spec for the macOS host, run with `rake spec`.  Calls made on the main thread while the stores are
+// loading, or after they failed to load, must return an error rather than raise.  The store is placed in a directory
+// that doesn't exist, so loading fails whichever state the main thread call sees.
+
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+#import "RHManagedObject.h"
+#import "RHManagedObjectContextManager.h"
+
+@interface RHSpecEmployee : RHManagedObject
+@property (nonatomic, strong) NSString *lastName;
+@end
+
+@implementation RHSpecEmployee
+@dynamic lastName;
+
++(NSString *)entityName {
+	return @"Employee";
+}
+
++(NSString *)modelName {
+	return @"RHStoreLoadingSpec";
+}
+@end
+
+
+static NSManagedObjectModel *RHSpecModel(void) {
+	NSAttributeDescription *attribute = [[NSAttributeDescription alloc] init];
+	[attribute setName:@"lastName"];
+	[attribute setAttributeType:NSStringAttributeType];
+	[attribute setOptional:YES];
+
+	NSEntityDescription *entity = [[NSEntityDescription alloc] init];
+	[entity setName:@"Employee"];
+	[entity setManagedObjectClassName:NSStringFromClass([RHSpecEmployee class])];
+	[entity setProperties:[NSArray arrayWithObject:attribute]];
+
+	NSManagedObjectModel *model = [[NSManagedObjectModel alloc] init];
+	[model setEntities:[NSArray arrayWithObject:entity]];
+
+	return model;
+}
+
+// Returns an error message, or nil if newEntityWithError: returned an error without raising
+static NSString *RHSpecNewEntityFails(void) {
+	@try {
+		NSError *error = nil;
+		id employee = [RHSpecEmployee newEntityWithError:&error];
+
+		if (employee) {
+			return @"newEntityWithError: returned an object";
+		}
+
+		if (error == nil) {
+			return @"newEntityWithError: returned nil without an error";
+		}
+	} @catch (NSException *exception) {
+		return [NSString stringWithFormat:@"newEntityWithError: raised %@: %@", [exception name], [exception reason]];
+	}
+
+	return nil;
+}
+
+int main(int argc, const char * argv[]) {
+	@autoreleasepool {
+		RHManagedObjectContextManager *manager = [RHManagedObjectContextManager sharedInstanceWithModelName:[RHSpecEmployee modelName]
+																									 bundle:[NSBundle bundleForClass:[RHSpecEmployee class]]];
+		RHStoreConfiguration *configuration = [[RHStoreConfiguration alloc] init];
+		configuration.storeType = NSSQLiteStoreType;
+		configuration.storeURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@/RHStoreLoadingSpec.sqlite", [[NSUUID UUID] UUIDString]]]];
+
+		[manager setManagedObjectModel:RHSpecModel()];
+		[manager setStoreConfigurations:[NSArray arrayWithObject:configuration]];
+
+		NSMutableArray *failures = [NSMutableArray array];
+		__block BOOL done = NO;
+		__block NSError *loadingError = nil;
+
+		[manager loadStoresWithCompletion:^(NSError *error) {
+			loadingError = error;
+			done = YES;
+		}];
+
+		NSString *failure = RHSpecNewEntityFails();
+		if (failure) {
+			[failures addObject:[NSString stringWithFormat:@"while loading: %@", failure]];
+		}
+
+		while (!done) {
+			[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+		}
+
+		if (loadingError == nil) {
+			[failures addObject:@"loadStoresWithCompletion: did not report an error"];
+		}
+
+		failure = RHSpecNewEntityFails();
+		if (failure) {
+			[failures addObject:[NSString stringWithFormat:@"after a failed load: %@", failure]];
+		}
+
+		for (NSString *message in failures) {
+			fprintf(stderr, "FAIL %s\n", [message UTF8String]);
+		}
+
+		if ([failures count] > 0) {
+			return 1;
+		}
+
+		printf("RHStoreLoadingSpec passed\n");
+	}
+
+	return 0;
+}